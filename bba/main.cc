@@ -19,6 +19,7 @@
  */
 
 #include <assert.h>
+#include <boost/crc.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/program_options.hpp>
 #include <iostream>
@@ -37,7 +38,8 @@ enum TokenType : int8_t
     TOK_U8,
     TOK_U16,
     TOK_U32,
-    TOK_ALIGN
+    TOK_ALIGN,
+    TOK_CRC32
 };
 
 struct Stream
@@ -57,6 +59,8 @@ std::vector<int64_t> labels;
 std::vector<std::string> labelNames;
 std::map<std::string, int> labelIndex;
 
+std::vector<std::pair<int, int>> checksums;
+
 std::vector<std::string> preText, postText;
 
 const char *skipWhitespace(const char *p)
@@ -195,6 +199,28 @@ int main(int argc, char **argv)
             continue;
         }
 
+        if (cmd == "crc32") {
+            const char *begin = strtok(nullptr, " \t\r\n");
+            const char *end = strtok(nullptr, " \t\r\n");
+            const char *comment = skipWhitespace(strtok(nullptr, "\r\n"));
+            assert(begin != nullptr && end != nullptr);
+            Stream &s = streams.at(streamStack.back());
+            for (auto label : {begin, end}) {
+                if (labelIndex.count(label) == 0) {
+                    labelIndex[label] = labels.size();
+                    if (debug)
+                        labelNames.push_back(label);
+                    labels.push_back(-1);
+                }
+            }
+            s.tokenTypes.push_back(TOK_CRC32);
+            s.tokenValues.push_back(checksums.size());
+            checksums.emplace_back(labelIndex.at(begin), labelIndex.at(end));
+            if (debug)
+                s.tokenComments.push_back(comment);
+            continue;
+        }
+
         if (cmd == "u8" || cmd == "u16" || cmd == "u32") {
             const char *value = strtok(nullptr, " \t\r\n");
             const char *comment = skipWhitespace(strtok(nullptr, "\r\n"));
@@ -277,6 +303,14 @@ int main(int argc, char **argv)
     streams.back().tokenValues.swap(stringStream.tokenValues);
     streams.back().tokenComments.swap(stringStream.tokenComments);
 
+    // The predefined label "$end" marks the end of the output, after the strings
+    if (labelIndex.count("$end") == 0) {
+        labelIndex["$end"] = labels.size();
+        if (debug)
+            labelNames.push_back("$end");
+        labels.push_back(-1);
+    }
+
     int64_t cursor = 0;
     for (auto &s : streams) {
         for (int64_t i = 0; i < int64_t(s.tokenTypes.size()); i++) {
@@ -289,6 +323,10 @@ int main(int argc, char **argv)
             case TOK_REF:
                 cursor += 4;
                 break;
+            case TOK_CRC32:
+                assert(cursor % 4 == 0);
+                cursor += 4;
+                break;
             case TOK_U8:
                 cursor += 1;
                 break;
@@ -310,12 +348,16 @@ int main(int argc, char **argv)
         }
     }
 
+    labels[labelIndex.at("$end")] = cursor;
+
     if (verbose) {
         printf("resolved positions for %d labels.\n", int(labels.size()));
         printf("total data (including strings): %.2f MB\n", double(cursor) / (1024 * 1024));
     }
 
     std::vector<uint8_t> data(cursor);
+    // Checksums are patched in once all other data has been written
+    std::vector<std::pair<int64_t, int>> checksumFixups;
 
     cursor = 0;
     for (auto &s : streams) {
@@ -348,6 +390,11 @@ int main(int argc, char **argv)
                 if (cursor % 4 != 0)
                     numBytes = 4 - (cursor % 4);
                 break;
+            case TOK_CRC32:
+                checksumFixups.emplace_back(cursor, value);
+                value = 0;
+                numBytes = 4;
+                break;
             default:
                 assert(0);
             }
@@ -433,6 +480,10 @@ int main(int argc, char **argv)
                     else
                         printf("u32 %-26llu %s\n", v, s.tokenComments[i].c_str());
                     break;
+                case TOK_CRC32:
+                    printf("crc32 %s %s %s\n", labelNames[checksums[v].first].c_str(),
+                           labelNames[checksums[v].second].c_str(), s.tokenComments[i].c_str());
+                    break;
                 default:
                     assert(0);
                 }
@@ -442,6 +493,21 @@ int main(int argc, char **argv)
 
     assert(cursor == int64_t(data.size()));
 
+    // All checksums are computed with every checksum word still zero, so a range may cover them
+    std::vector<uint32_t> checksumValues;
+    for (auto &fixup : checksumFixups) {
+        int64_t begin = labels[checksums[fixup.second].first], end = labels[checksums[fixup.second].second];
+        assert(begin >= 0 && begin <= end && end <= int64_t(data.size()));
+        boost::crc_32_type crc;
+        crc.process_block(data.data() + begin, data.data() + end);
+        checksumValues.push_back(crc.checksum());
+    }
+    for (size_t i = 0; i < checksumFixups.size(); i++) {
+        uint32_t value = checksumValues[i];
+        for (int k = 0; k < 4; k++)
+            data[checksumFixups[i].first + k] = bigEndian ? (value >> (8 * (3 - k))) : (value >> (8 * k));
+    }
+
     if (writeC) {
         for (auto &s : preText)
             fprintf(fileOut, "%s\n", s.c_str());
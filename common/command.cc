@@ -138,6 +138,14 @@ po::options_description CommandHandler::getGeneralOptions()
                         "; default: " + Arch::defaultRouter)
                     .c_str());
 
+    general.add_options()("threads", po::value<int>(),
+                          "maximum number of threads used by multi-threaded steps (default: hardware concurrency)");
+    general.add_options()("router2-threads", po::value<int>(),
+                          "maximum number of threads used by router2 (default: --threads)");
+    general.add_options()("router2-partition-depth", po::value<int>(),
+                          "levels of bisection into regions routed concurrently by router2; up to 2^depth regions "
+                          "run at once, but more nets cross a split and are routed serially (default: 5)");
+
     general.add_options()("slack_redist_iter", po::value<int>(), "number of iterations between slack redistribution");
     general.add_options()("cstrweight", po::value<float>(), "placer weighting for relative constraint satisfaction");
     general.add_options()("starttemp", po::value<float>(), "placer SA start temperature");
@@ -147,6 +155,9 @@ po::options_description CommandHandler::getGeneralOptions()
     general.add_options()("no-route", "process design without routing");
     general.add_options()("no-place", "process design without placement");
     general.add_options()("no-pack", "process design without packing");
+    general.add_options()("eco", "keep the packing, placement and routing of a routed design loaded from JSON, and only "
+                                 "route the nets whose routing no longer matches their cells (e.g. after a pre-route "
+                                 "script moves cells)");
 
     general.add_options()("ignore-loops", "ignore combinational loops in timing analysis");
 
@@ -229,6 +240,19 @@ void CommandHandler::setupContext(Context *ctx)
         ctx->settings[ctx->id("router")] = router;
     }
 
+    if (vm.count("eco") && !vm.count("json"))
+        log_error("ECO mode needs a routed design, loaded with --json\n");
+
+    if (vm.count("threads")) {
+        ctx->settings[ctx->id("threads")] = vm["threads"].as<int>();
+    }
+    if (vm.count("router2-threads")) {
+        ctx->settings[ctx->id("router2/threads")] = vm["router2-threads"].as<int>();
+    }
+    if (vm.count("router2-partition-depth")) {
+        ctx->settings[ctx->id("router2/partitionDepth")] = vm["router2-partition-depth"].as<int>();
+    }
+
     if (vm.count("cstrweight")) {
         ctx->settings[ctx->id("placer1/constraintWeight")] = std::to_string(vm["cstrweight"].as<float>());
     }
@@ -302,6 +326,11 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
         std::ifstream f(filename);
         if (!parse_json(f, filename, ctx.get()))
             log_error("Loading design failed.\n");
+        // Set after loading, so that the mode of the run that wrote the design does not carry over
+        if (vm.count("eco"))
+            ctx->settings[ctx->id("eco")] = true;
+        else
+            ctx->settings.erase(ctx->id("eco"));
 
         customAfterLoad(ctx.get());
     }
@@ -319,8 +348,10 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
 #endif
 
     if (vm.count("json")) {
-        bool do_pack = vm.count("pack-only") != 0 || vm.count("no-pack") == 0;
-        bool do_place = vm.count("pack-only") == 0 && vm.count("no-place") == 0;
+        // An ECO run starts from a design that has already been packed and placed
+        bool eco = vm.count("eco") != 0;
+        bool do_pack = !eco && (vm.count("pack-only") != 0 || vm.count("no-pack") == 0);
+        bool do_place = !eco && vm.count("pack-only") == 0 && vm.count("no-place") == 0;
         bool do_route = vm.count("pack-only") == 0 && vm.count("no-route") == 0;
 
         if (do_pack) {
@@ -341,6 +372,11 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
 
         if (do_route) {
             run_script_hook("pre-route");
+            if (eco)
+                for (auto &cell : ctx->cells)
+                    if (cell.second->bel == BelId())
+                        log_error("ECO mode needs a placed design, but cell '%s' is not placed.\n",
+                                  ctx->nameOf(cell.second.get()));
             if (!ctx->route() && !ctx->force)
                 log_error("Routing design failed.\n");
             run_script_hook("post-route");
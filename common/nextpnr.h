@@ -865,6 +865,10 @@ struct Context : Arch, DeterministicRNG
 
     // provided by router1.cc
     bool checkRoutedDesign() const;
+    // Unbinds the routing of each net that is not on a path from its source to one of its current sinks, as left
+    // behind when cells of a routed design are moved or reconnected; bindings stronger than STRENGTH_STRONG are kept.
+    // Returns the nets that still have unrouted sinks.
+    std::vector<NetInfo *> pruneRouting();
     bool getActualRouteDelay(WireId src_wire, WireId dst_wire, delay_t *delay = nullptr,
                              std::unordered_map<WireId, PipId> *route = nullptr, bool useEstimate = true);
 
@@ -17,6 +17,7 @@
  *
  */
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <queue>
@@ -39,16 +40,6 @@ struct arc_key
     {
         return net_info == other.net_info ? user_idx < other.user_idx : net_info->name < other.net_info->name;
     }
-
-    struct Hash
-    {
-        std::size_t operator()(const arc_key &arg) const noexcept
-        {
-            std::size_t seed = std::hash<NetInfo *>()(arg.net_info);
-            seed ^= std::hash<int>()(arg.user_idx) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            return seed;
-        }
-    };
 };
 
 struct arc_entry
@@ -97,25 +88,151 @@ struct Router1
     const Router1Cfg &cfg;
 
     std::priority_queue<arc_entry, std::vector<arc_entry>, arc_entry::Less> arc_queue;
-    std::unordered_map<WireId, std::unordered_set<arc_key, arc_key::Hash>> wire_to_arcs;
-    std::unordered_map<arc_key, std::unordered_set<WireId>, arc_key::Hash> arc_to_wires;
-    std::unordered_set<arc_key, arc_key::Hash> queued_arcs;
 
-    std::unordered_map<WireId, QueuedWire> visited;
+    // Each use of a wire by an arc is listed both on the arc and on the wire, and each entry holds the position of
+    // the other, so that a use can be removed in constant time even on wires shared by a whole high-fanout net
+    struct ArcWire
+    {
+        WireId wire;
+        // Index in the wire's arcs
+        int slot;
+    };
+
+    struct WireArc
+    {
+        arc_key arc;
+        // Index in the arc's wires
+        int slot;
+    };
+
+    struct PerArcData
+    {
+        // Wires of the current route of this arc, in no particular order
+        std::vector<ArcWire> wires;
+        bool queued = false;
+    };
+
+    struct PerNetData
+    {
+        // Indexed by user index
+        std::vector<PerArcData> arcs;
+        int score = 0;
+    };
+
+    struct WireVisit
+    {
+        PipId pip;
+        delay_t delay = 0, penalty = 0, bonus = 0;
+    };
+
+    struct PerWireData
+    {
+        // Arcs whose route uses this wire
+        std::vector<WireArc> arcs;
+        int score = 0;
+        // The visit is only valid if visit_epoch matches the epoch of the current arc
+        uint32_t visit_epoch = 0;
+        WireVisit visit;
+    };
+
+    // Indexed by net udata
+    std::vector<PerNetData> nets;
+    std::vector<int32_t> old_udata;
+    std::vector<PerWireData> wires;
+    uint32_t epoch = 0;
+
     std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> queue;
 
-    std::unordered_map<WireId, int> wireScores;
-    std::unordered_map<NetInfo *, int> netScores;
+#ifdef ARCH_XILINX
+    int wire_index(WireId wire) const { return ctx->getWireIndex(wire); }
+#else
+    // Other architectures have no dense wire index of their own, so one is built up front
+    std::unordered_map<WireId, int> wire_indices;
+    int wire_index(WireId wire) const { return wire_indices.at(wire); }
+#endif
+    PerWireData &wire_data(WireId wire) { return wires[wire_index(wire)]; }
+    PerArcData &arc_data(const arc_key &arc) { return nets[arc.net_info->udata].arcs[arc.user_idx]; }
+
+    int wire_score(WireId wire) { return wire_data(wire).score; }
+    void bump_wire_score(WireId wire) { wire_data(wire).score++; }
+
+    const WireVisit *get_visit(WireId wire)
+    {
+        auto &wd = wire_data(wire);
+        return wd.visit_epoch == epoch ? &wd.visit : nullptr;
+    }
+
+    void set_visit(WireId wire, const QueuedWire &qw)
+    {
+        auto &wd = wire_data(wire);
+        wd.visit_epoch = epoch;
+        wd.visit.pip = qw.pip;
+        wd.visit.delay = qw.delay;
+        wd.visit.penalty = qw.penalty;
+        wd.visit.bonus = qw.bonus;
+    }
+
+    void add_arc_wire(const arc_key &arc, WireId wire)
+    {
+        auto &wire_arcs = wire_data(wire).arcs;
+        auto &arc_wires = arc_data(arc).wires;
+        wire_arcs.push_back(WireArc{arc, int(arc_wires.size())});
+        arc_wires.push_back(ArcWire{wire, int(wire_arcs.size()) - 1});
+    }
+
+    // Remove one entry of a wire's or an arc's list by moving the last one into its place; only the moved entry's
+    // counterpart on the other side needs updating
+    void erase_wire_arc(std::vector<WireArc> &wire_arcs, int slot)
+    {
+        if (slot != int(wire_arcs.size()) - 1) {
+            wire_arcs[slot] = wire_arcs.back();
+            arc_data(wire_arcs[slot].arc).wires[wire_arcs[slot].slot].slot = slot;
+        }
+        wire_arcs.pop_back();
+    }
+
+    void erase_arc_wire(std::vector<ArcWire> &arc_wires, int slot)
+    {
+        if (slot != int(arc_wires.size()) - 1) {
+            arc_wires[slot] = arc_wires.back();
+            wire_data(arc_wires[slot].wire).arcs[arc_wires[slot].slot].slot = slot;
+        }
+        arc_wires.pop_back();
+    }
 
     int arcs_with_ripup = 0;
     int arcs_without_ripup = 0;
     bool ripup_flag;
 
-    Router1(Context *ctx, const Router1Cfg &cfg) : ctx(ctx), cfg(cfg) {}
+    Router1(Context *ctx, const Router1Cfg &cfg) : ctx(ctx), cfg(cfg)
+    {
+#ifdef ARCH_XILINX
+        wires.resize(ctx->getWireIndexCount());
+#else
+        for (WireId wire : ctx->getWires())
+            wire_indices.emplace(wire, int(wire_indices.size()));
+        wires.resize(wire_indices.size());
+#endif
+        nets.resize(ctx->nets.size());
+        old_udata.reserve(ctx->nets.size());
+        decltype(NetInfo::udata) n = 0;
+        for (auto &net : ctx->nets) {
+            old_udata.emplace_back(net.second->udata);
+            nets.at(n).arcs.resize(net.second->users.size());
+            net.second->udata = n++;
+        }
+    }
+
+    ~Router1()
+    {
+        for (auto &net : ctx->nets)
+            net.second->udata = old_udata[net.second->udata];
+    }
 
     void arc_queue_insert(const arc_key &arc, WireId src_wire, WireId dst_wire)
     {
-        if (queued_arcs.count(arc))
+        auto &ad = arc_data(arc);
+        if (ad.queued)
             return;
 
         delay_t pri = ctx->estimateDelay(src_wire, dst_wire) - arc.net_info->users[arc.user_idx].budget;
@@ -132,12 +249,12 @@ struct Router1
 #endif
 
         arc_queue.push(entry);
-        queued_arcs.insert(arc);
+        ad.queued = true;
     }
 
     void arc_queue_insert(const arc_key &arc)
     {
-        if (queued_arcs.count(arc))
+        if (arc_data(arc).queued)
             return;
 
         NetInfo *net_info = arc.net_info;
@@ -160,41 +277,49 @@ struct Router1
 #endif
 
         arc_queue.pop();
-        queued_arcs.erase(entry.arc);
+        arc_data(entry.arc).queued = false;
         return entry.arc;
     }
 
+    // Detach w from every arc whose route uses it, and requeue those arcs
+    void requeue_wire_arcs(WireId w)
+    {
+        std::vector<WireArc> wire_arcs;
+        wire_arcs.swap(wire_data(w).arcs);
+
+        std::vector<arc_key> arcs;
+        for (auto &wa : wire_arcs) {
+            erase_arc_wire(arc_data(wa.arc).wires, wa.slot);
+            arcs.push_back(wa.arc);
+        }
+
+        ctx->sorted_shuffle(arcs);
+
+        for (auto &arc : arcs)
+            arc_queue_insert(arc);
+    }
+
     void ripup_net(NetInfo *net)
     {
         if (ctx->debug)
             log("      ripup net %s\n", ctx->nameOf(net));
 
-        netScores[net]++;
+        nets[net->udata].score++;
 
-        std::vector<WireId> wires;
+        std::vector<WireId> net_wires;
         for (auto &it : net->wires)
-            wires.push_back(it.first);
+            net_wires.push_back(it.first);
 
-        ctx->sorted_shuffle(wires);
+        ctx->sorted_shuffle(net_wires);
 
-        for (WireId w : wires) {
-            std::vector<arc_key> arcs;
-            for (auto &it : wire_to_arcs[w]) {
-                arc_to_wires[it].erase(w);
-                arcs.push_back(it);
-            }
-            wire_to_arcs[w].clear();
-
-            ctx->sorted_shuffle(arcs);
-
-            for (auto &it : arcs)
-                arc_queue_insert(it);
+        for (WireId w : net_wires) {
+            requeue_wire_arcs(w);
 
             if (ctx->debug)
                 log("        unbind wire %s\n", ctx->nameOfWire(w));
 
             ctx->unbindWire(w);
-            wireScores[w]++;
+            bump_wire_score(w);
         }
 
         ripup_flag = true;
@@ -212,23 +337,13 @@ struct Router1
             if (n != nullptr)
                 ripup_net(n);
         } else {
-            std::vector<arc_key> arcs;
-            for (auto &it : wire_to_arcs[w]) {
-                arc_to_wires[it].erase(w);
-                arcs.push_back(it);
-            }
-            wire_to_arcs[w].clear();
-
-            ctx->sorted_shuffle(arcs);
-
-            for (auto &it : arcs)
-                arc_queue_insert(it);
+            requeue_wire_arcs(w);
 
             if (ctx->debug)
                 log("      unbind wire %s\n", ctx->nameOfWire(w));
 
             ctx->unbindWire(w);
-            wireScores[w]++;
+            bump_wire_score(w);
         }
 
         ripup_flag = true;
@@ -246,23 +361,13 @@ struct Router1
             if (n != nullptr)
                 ripup_net(n);
         } else {
-            std::vector<arc_key> arcs;
-            for (auto &it : wire_to_arcs[w]) {
-                arc_to_wires[it].erase(w);
-                arcs.push_back(it);
-            }
-            wire_to_arcs[w].clear();
-
-            ctx->sorted_shuffle(arcs);
-
-            for (auto &it : arcs)
-                arc_queue_insert(it);
+            requeue_wire_arcs(w);
 
             if (ctx->debug)
                 log("      unbind wire %s\n", ctx->nameOfWire(w));
 
             ctx->unbindWire(w);
-            wireScores[w]++;
+            bump_wire_score(w);
         }
 
         ripup_flag = true;
@@ -284,14 +389,20 @@ struct Router1
 
     void check()
     {
-        std::unordered_set<arc_key, arc_key::Hash> valid_arcs;
+        size_t arc_wire_count = 0;
 
         for (auto &net_it : ctx->nets) {
             NetInfo *net_info = net_it.second.get();
+            auto &nd = nets[net_info->udata];
             std::unordered_set<WireId> valid_wires_for_net;
 
-            if (skip_net(net_info))
+            log_assert(int(nd.arcs.size()) == int(net_info->users.size()));
+
+            if (skip_net(net_info)) {
+                for (auto &ad : nd.arcs)
+                    log_assert(ad.wires.empty());
                 continue;
+            }
 
 #if 0
             if (ctx->debug)
@@ -309,19 +420,23 @@ struct Router1
                 arc.net_info = net_info;
                 arc.user_idx = user_idx;
 
-                valid_arcs.insert(arc);
 #if 0
                 if (ctx->debug)
                     log("[check]   arc: %s %s\n", ctx->nameOfWire(src_wire), ctx->nameOfWire(dst_wire));
 #endif
 
-                for (WireId wire : arc_to_wires[arc]) {
+                arc_wire_count += nd.arcs[user_idx].wires.size();
+                auto &arc_wires = nd.arcs[user_idx].wires;
+                for (int i = 0; i < int(arc_wires.size()); i++) {
+                    WireId wire = arc_wires[i].wire;
 #if 0
                     if (ctx->debug)
                         log("[check]     wire: %s\n", ctx->nameOfWire(wire));
 #endif
                     valid_wires_for_net.insert(wire);
-                    log_assert(wire_to_arcs[wire].count(arc));
+                    auto &wire_arcs = wire_data(wire).arcs;
+                    log_assert(arc_wires[i].slot >= 0 && arc_wires[i].slot < int(wire_arcs.size()));
+                    log_assert(wire_arcs[arc_wires[i].slot].arc == arc && wire_arcs[arc_wires[i].slot].slot == i);
                     log_assert(net_info->wires.count(wire));
                 }
             }
@@ -332,14 +447,16 @@ struct Router1
             }
         }
 
-        for (auto &it : wire_to_arcs) {
-            for (auto &arc : it.second)
-                log_assert(valid_arcs.count(arc));
-        }
-
-        for (auto &it : arc_to_wires) {
-            log_assert(valid_arcs.count(it.first));
+        // Every arc listed on a wire must list that wire in turn
+        size_t wire_arc_count = 0;
+        for (auto &wd : wires) {
+            for (auto &wa : wd.arcs) {
+                log_assert(!skip_net(wa.arc.net_info));
+                log_assert(wa.arc.user_idx >= 0 && wa.arc.user_idx < int(wa.arc.net_info->users.size()));
+            }
+            wire_arc_count += wd.arcs.size();
         }
+        log_assert(wire_arc_count == arc_wire_count);
     }
 
     void setup()
@@ -406,8 +523,7 @@ struct Router1
                 }
 
                 WireId cursor = dst_wire;
-                wire_to_arcs[cursor].insert(arc);
-                arc_to_wires[arc].insert(cursor);
+                add_arc_wire(arc, cursor);
 
                 while (src_wire != cursor) {
                     auto it = net_info->wires.find(cursor);
@@ -418,8 +534,7 @@ struct Router1
 
                     NPNR_ASSERT(it->second.pip != PipId());
                     cursor = ctx->getPipSrcWire(it->second.pip);
-                    wire_to_arcs[cursor].insert(arc);
-                    arc_to_wires[arc].insert(cursor);
+                    add_arc_wire(arc, cursor);
                 }
             }
 
@@ -428,7 +543,7 @@ struct Router1
             std::vector<WireId> unbind_wires;
 
             for (auto &it : net_info->wires)
-                if (it.second.strength < STRENGTH_LOCKED && wire_to_arcs.count(it.first) == 0)
+                if (it.second.strength < STRENGTH_LOCKED && wire_data(it.first).arcs.empty())
                     unbind_wires.push_back(it.first);
 
             for (auto it : unbind_wires) {
@@ -460,14 +575,14 @@ struct Router1
 
         // unbind wires that are currently used exclusively by this arc
 
-        std::unordered_set<WireId> old_arc_wires;
-        old_arc_wires.swap(arc_to_wires[arc]);
+        std::vector<ArcWire> old_arc_wires;
+        old_arc_wires.swap(arc_data(arc).wires);
 
-        for (WireId wire : old_arc_wires) {
-            auto &arc_wires = wire_to_arcs.at(wire);
-            NPNR_ASSERT(arc_wires.count(arc));
-            arc_wires.erase(arc);
-            if (arc_wires.empty()) {
+        for (auto &aw : old_arc_wires) {
+            WireId wire = aw.wire;
+            auto &wire_arcs = wire_data(wire).arcs;
+            erase_wire_arc(wire_arcs, aw.slot);
+            if (wire_arcs.empty()) {
                 if (ctx->debug)
                     log("  unbind %s\n", ctx->nameOfWire(wire));
                 ctx->unbindWire(wire);
@@ -480,7 +595,13 @@ struct Router1
             std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> new_queue;
             queue.swap(new_queue);
         }
-        visited.clear();
+
+        // Moving to a new epoch invalidates all visits of the previous arc at once
+        if (++epoch == 0) {
+            for (auto &wd : wires)
+                wd.visit_epoch = 0;
+            epoch = 1;
+        }
 
         // A* main loop
 
@@ -503,7 +624,7 @@ struct Router1
             qw.randtag = ctx->rng();
 
             queue.push(qw);
-            visited[qw.wire] = qw;
+            set_visit(qw.wire, qw);
         }
 
         while (visitCnt++ < maxVisitCnt && !queue.empty() && (src_wire != dst_wire)) {
@@ -521,7 +642,7 @@ struct Router1
                 WireId conflictWireWire = WireId(), conflictPipWire = WireId();
                 NetInfo *conflictWireNet = nullptr, *conflictPipNet = nullptr;
 
-                if (net_info->wires.count(next_wire) && net_info->wires.at(next_wire).pip == pip) {
+                if (ctx->getBoundWireNet(next_wire) == net_info && net_info->wires.at(next_wire).pip == pip) {
                     next_bonus += cfg.reuseBonus;
                 } else {
                     if (!ctx->checkWireAvail(next_wire)) {
@@ -589,10 +710,8 @@ struct Router1
                         conflictWireNet = nullptr;
 
                     if (conflictWireWire != WireId()) {
-                        auto scores_it = wireScores.find(conflictWireWire);
                         delay_t wire_penalty = ctx->getWireRipupDelayPenalty(conflictWireWire);
-                        if (scores_it != wireScores.end())
-                            next_penalty += scores_it->second * wire_penalty;
+                        next_penalty += wire_score(conflictWireWire) * wire_penalty;
                         next_penalty += wire_penalty;
 
                         NetInfo *bound = ctx->getBoundWireNet(conflictWireWire);
@@ -604,10 +723,8 @@ struct Router1
                     }
 
                     if (conflictPipWire != WireId()) {
-                        auto scores_it = wireScores.find(conflictPipWire);
                         delay_t wire_penalty = ctx->getWireRipupDelayPenalty(conflictPipWire);
-                        if (scores_it != wireScores.end())
-                            next_penalty += scores_it->second * wire_penalty;
+                        next_penalty += wire_score(conflictPipWire) * wire_penalty;
                         next_penalty += wire_penalty;
 
                         NetInfo *bound = ctx->getBoundWireNet(conflictPipWire);
@@ -619,17 +736,13 @@ struct Router1
                     }
 
                     if (conflictWireNet != nullptr) {
-                        auto scores_it = netScores.find(conflictWireNet);
-                        if (scores_it != netScores.end())
-                            next_penalty += scores_it->second * cfg.netRipupPenalty;
+                        next_penalty += nets[conflictWireNet->udata].score * cfg.netRipupPenalty;
                         next_penalty += cfg.netRipupPenalty;
                         next_penalty += conflictWireNet->wires.size() * cfg.wireRipupPenalty;
                     }
 
                     if (conflictPipNet != nullptr) {
-                        auto scores_it = netScores.find(conflictPipNet);
-                        if (scores_it != netScores.end())
-                            next_penalty += scores_it->second * cfg.netRipupPenalty;
+                        next_penalty += nets[conflictPipNet->udata].score * cfg.netRipupPenalty;
                         next_penalty += cfg.netRipupPenalty;
                         next_penalty += conflictPipNet->wires.size() * cfg.wireRipupPenalty;
                     }
@@ -638,10 +751,8 @@ struct Router1
                     int bb_dist = bounds.distance(piploc);
                     next_penalty += ctx->getBoundingBoxCost(src_wire, dst_wire, bb_dist);
 
-                    auto scores_it = wireScores.find(next_wire);
                     delay_t wire_penalty = ctx->getWireRipupDelayPenalty(next_wire);
-                    if (scores_it != wireScores.end())
-                        next_penalty += (scores_it->second * wire_penalty) / 5;
+                    next_penalty += (wire_score(next_wire) * wire_penalty) / 5;
                 }
 
                 delay_t next_score = next_delay + next_penalty;
@@ -650,10 +761,10 @@ struct Router1
                 if ((best_score >= 0) && (next_score - next_bonus - cfg.estimatePrecision > best_score))
                     continue;
 
-                auto old_visited_it = visited.find(next_wire);
-                if (old_visited_it != visited.end()) {
-                    delay_t old_delay = old_visited_it->second.delay;
-                    delay_t old_score = old_delay + old_visited_it->second.penalty;
+                const WireVisit *old_visit = get_visit(next_wire);
+                if (old_visit != nullptr) {
+                    delay_t old_delay = old_visit->delay;
+                    delay_t old_score = old_delay + old_visit->penalty;
                     NPNR_ASSERT(old_score >= 0);
 
                     if (next_score + ctx->getDelayEpsilon() >= old_score)
@@ -664,7 +775,7 @@ struct Router1
                         log("Found better route to %s. Old vs new delay estimate: %.3f (%.3f) %.3f (%.3f)\n",
                             ctx->nameOfWire(next_wire),
                             ctx->getDelayNS(old_score),
-                            ctx->getDelayNS(old_visited_it->second.delay),
+                            ctx->getDelayNS(old_visit->delay),
                             ctx->getDelayNS(next_score),
                             ctx->getDelayNS(next_delay));
 #endif
@@ -695,7 +806,7 @@ struct Router1
                         ctx->getDelayNS(next_delay));
 #endif
 
-                visited[next_qw.wire] = next_qw;
+                set_visit(next_qw.wire, next_qw);
                 queue.push(next_qw);
 
                 if (next_wire == dst_wire) {
@@ -708,28 +819,27 @@ struct Router1
         if (ctx->debug)
             log("  total number of visited nodes: %d\n", visitCnt);
 
-        if (visited.count(dst_wire) == 0) {
+        const WireVisit *dst_visit = get_visit(dst_wire);
+        if (dst_visit == nullptr) {
             if (ctx->debug)
                 log("  no route found for this arc\n");
             return false;
         }
 
         if (ctx->debug) {
-            log("  final route delay:   %8.2f\n", ctx->getDelayNS(visited[dst_wire].delay));
-            log("  final route penalty: %8.2f\n", ctx->getDelayNS(visited[dst_wire].penalty));
-            log("  final route bonus:   %8.2f\n", ctx->getDelayNS(visited[dst_wire].bonus));
+            log("  final route delay:   %8.2f\n", ctx->getDelayNS(dst_visit->delay));
+            log("  final route penalty: %8.2f\n", ctx->getDelayNS(dst_visit->penalty));
+            log("  final route bonus:   %8.2f\n", ctx->getDelayNS(dst_visit->bonus));
             log("  arc budget:      %12.2f\n", ctx->getDelayNS(net_info->users[user_idx].budget));
         }
 
         // bind resulting route (and maybe unroute other nets)
 
-        std::unordered_set<WireId> unassign_wires = arc_to_wires[arc];
-
         WireId cursor = dst_wire;
         delay_t accumulated_path_delay = 0;
         delay_t last_path_delay_delta = 0;
         while (1) {
-            auto pip = visited[cursor].pip;
+            auto pip = get_visit(cursor)->pip;
 
             if (ctx->debug) {
                 delay_t path_delay_delta = ctx->estimateDelay(cursor, dst_wire) - accumulated_path_delay;
@@ -740,8 +850,8 @@ struct Router1
                     ctx->getDelayNS(path_delay_delta - last_path_delay_delta));
 
                 last_path_delay_delta = path_delay_delta;
-                if (wireScores.count(cursor))
-                    log("         wire score %d\n", wireScores.at(cursor));
+                if (wire_score(cursor) != 0)
+                    log("         wire score %d\n", wire_score(cursor));
                 if (pip != PipId())
                     accumulated_path_delay += ctx->getPipDelay(pip).maxDelay();
                 accumulated_path_delay += ctx->getWireDelay(cursor).maxDelay();
@@ -774,8 +884,7 @@ struct Router1
                 }
             }
 
-            wire_to_arcs[cursor].insert(arc);
-            arc_to_wires[arc].insert(cursor);
+            add_arc_wire(arc, cursor);
 
             if (pip == PipId())
                 break;
@@ -1072,6 +1181,74 @@ bool Context::checkRoutedDesign() const
     return true;
 }
 
+std::vector<NetInfo *> Context::pruneRouting()
+{
+    std::vector<NetInfo *> unrouted_nets;
+
+    for (auto &net_it : nets) {
+        NetInfo *net_info = net_it.second.get();
+
+#ifdef ARCH_ECP5
+        if (net_info->is_global)
+            continue;
+#endif
+
+        auto src_wire = getNetinfoSourceWire(net_info);
+        if (src_wire == WireId())
+            continue;
+
+        // Wires known to lead back to the source
+        std::unordered_set<WireId> keep_wires;
+        bool unrouted = false;
+        std::vector<WireId> path;
+
+        for (auto &usr : net_info->users) {
+            auto dst_wire = getNetinfoSinkWire(net_info, usr);
+            if (dst_wire == WireId())
+                continue;
+
+            // The walk is bounded, so that a loop in the bindings can't hang it
+            bool reached = false;
+            path.clear();
+            WireId cursor = dst_wire;
+            while (path.size() <= net_info->wires.size()) {
+                auto it = net_info->wires.find(cursor);
+                if (it == net_info->wires.end())
+                    break;
+                path.push_back(cursor);
+                if (cursor == src_wire || keep_wires.count(cursor)) {
+                    reached = true;
+                    break;
+                }
+                if (it->second.pip == PipId())
+                    break;
+                cursor = getPipSrcWire(it->second.pip);
+            }
+
+            if (reached)
+                keep_wires.insert(path.begin(), path.end());
+            else
+                unrouted = true;
+        }
+
+        std::vector<WireId> unbind_wires;
+        for (auto &it : net_info->wires)
+            if (it.second.strength <= STRENGTH_STRONG && !keep_wires.count(it.first))
+                unbind_wires.push_back(it.first);
+
+        for (auto w : unbind_wires) {
+            if (debug)
+                log_info("   pruning wire %s from net %s\n", nameOfWire(w), nameOf(net_info));
+            unbindWire(w);
+        }
+
+        if (unrouted)
+            unrouted_nets.push_back(net_info);
+    }
+
+    return unrouted_nets;
+}
+
 bool Context::getActualRouteDelay(WireId src_wire, WireId dst_wire, delay_t *delay,
                                   std::unordered_map<WireId, PipId> *route, bool useEstimate)
 {
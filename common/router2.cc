@@ -28,10 +28,13 @@
 
 #include "router2.h"
 #include <algorithm>
-#include <boost/container/flat_map.hpp>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <thread>
 #include "log.h"
@@ -64,8 +67,24 @@ struct Router2
         // Coordinates of the center of the net, used for the weight-to-average
         int cx, cy, hpwl;
         int total_route_us = 0;
+        // Overuse of the wires this net shared after the most recent iteration
+        int overuse = 0;
+        // Wires expanded the last time the net was routed (-1 if it hasn't been yet), used to schedule large nets
+        // first. Unlike routing time, this doesn't vary between runs.
+        int64_t last_explored = -1;
         float max_crit = 0;
         int fail_count = 0;
+        // In ECO mode, the routing the net was loaded with is complete; it is left as it is, and its wires are
+        // unavailable to other nets
+        bool frozen = false;
+        // Box of the wires bound to the net, which may lie outside bb after routing without a bounding box or when
+        // the routing was loaded with the design. Ripping up and checking the net's routing touches all of them, so
+        // the net is only routed concurrently with nets whose boxes are disjoint from this. pinned_bb covers the
+        // bound wires that aren't on the path of any routed arc, such as locked clock routing, which remain bound.
+        ArcBounds route_bb{std::numeric_limits<int>::max(), std::numeric_limits<int>::max(),
+                           std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
+        ArcBounds pinned_bb{std::numeric_limits<int>::max(), std::numeric_limits<int>::max(),
+                            std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
     };
 
     struct WireScore
@@ -76,27 +95,93 @@ struct Router2
         float total() const { return cost + togo_cost; }
     };
 
+    // Nets using a wire: net --> number of arcs; driving pip. Almost every wire carries at most one net, so that
+    // entry is stored inline and the heap is only used while a wire is shared
+    struct BoundNets
+    {
+        typedef std::pair<int, std::pair<int, PipId>> value_type;
+
+        size_t size() const { return shared ? shared->size() : (single.first != -1 ? 1 : 0); }
+        bool empty() const { return size() == 0; }
+        const value_type *begin() const { return shared ? shared->data() : &single; }
+        const value_type *end() const { return begin() + size(); }
+        size_t count(int net) const { return index_of(net) != -1 ? 1 : 0; }
+
+        std::pair<int, PipId> &at(int net)
+        {
+            int i = index_of(net);
+            NPNR_ASSERT(i != -1);
+            return data()[i].second;
+        }
+
+        std::pair<int, PipId> &operator[](int net)
+        {
+            int i = index_of(net);
+            if (i != -1)
+                return data()[i].second;
+            if (!shared && single.first == -1) {
+                single = value_type(net, std::make_pair(0, PipId()));
+                return single.second;
+            }
+            if (!shared) {
+                shared.reset(new std::vector<value_type>(1, single));
+                single.first = -1;
+            }
+            shared->emplace_back(net, std::make_pair(0, PipId()));
+            return shared->back().second;
+        }
+
+        void erase(int net)
+        {
+            int i = index_of(net);
+            if (i == -1)
+                return;
+            if (!shared) {
+                single.first = -1;
+                return;
+            }
+            shared->erase(shared->begin() + i);
+            if (shared->size() == 1) {
+                single = shared->front();
+                shared.reset();
+            }
+        }
+
+      private:
+        value_type single{-1, std::make_pair(0, PipId())};
+        std::unique_ptr<std::vector<value_type>> shared;
+
+        value_type *data() { return shared ? shared->data() : &single; }
+        int index_of(int net) const
+        {
+            for (auto it = begin(); it != end(); ++it)
+                if (it->first == net)
+                    return int(it - begin());
+            return -1;
+        }
+    };
+
     struct PerWireData
     {
         // nextpnr
         WireId w;
-        // net --> number of arcs; driving pip
-        boost::container::flat_map<int, std::pair<int, PipId>> bound_nets;
+        BoundNets bound_nets;
         // Historical congestion cost
         float hist_cong_cost = 1.0;
-        // Wire is unavailable as locked to another arc
-        bool unavailable = false;
         // This wire has to be used for this net
         int reserved_net = -1;
         // The notional location of the wire, to guarantee thread safety
         int16_t x = 0, y = 0;
-        // Visit data
-        struct
-        {
-            bool dirty = false, visited = false;
-            PipId pip;
-            WireScore score;
-        } visit;
+        // Wire is unavailable as locked to another arc
+        bool unavailable = false;
+    };
+
+    // Visit data, kept apart from PerWireData as the search checks it for every wire it reaches
+    struct WireVisit
+    {
+        bool dirty = false, visited = false;
+        PipId pip;
+        WireScore score;
     };
 
     float present_wire_cost(const PerWireData &w, int net_uid)
@@ -113,7 +198,10 @@ struct Router2
     Context *ctx;
     Router2Cfg cfg;
 
-    Router2(Context *ctx, const Router2Cfg &cfg) : ctx(ctx), cfg(cfg) {}
+    Router2(Context *ctx, const Router2Cfg &cfg) : ctx(ctx), cfg(cfg)
+    {
+        this->cfg.thread_count = std::max(1, cfg.thread_count);
+    }
 
     // Use 'udata' for fast net lookups and indexing
     std::vector<NetInfo *> nets_by_udata;
@@ -201,15 +289,25 @@ struct Router2
         }
     }
 
+#ifdef ARCH_XILINX
+    // Indexed by Arch::getWireIndex; -1 for indices that are not a wire
+    std::vector<int> wire_to_idx;
+    int wire_idx(WireId w) const { return wire_to_idx[ctx->getWireIndex(w)]; }
+#else
     dict<WireId, int> wire_to_idx;
+    int wire_idx(WireId w) const { return wire_to_idx.at(w); }
+#endif
     std::vector<PerWireData> flat_wires;
+    std::vector<WireVisit> wire_visits;
 
-    PerWireData &wire_data(WireId w) { return flat_wires[wire_to_idx.at(w)]; }
+    PerWireData &wire_data(WireId w) { return flat_wires[wire_idx(w)]; }
 
     void setup_wires()
     {
         // Set up per-wire structures, so that MT parts don't have to do any memory allocation
-        // This is possibly quite wasteful and not cache-optimal; further consideration necessary
+#ifdef ARCH_XILINX
+        wire_to_idx.resize(ctx->getWireIndexCount(), -1);
+#endif
         for (auto wire : ctx->getWires()) {
             PerWireData pwd;
             pwd.w = wire;
@@ -224,38 +322,47 @@ struct Router2
             pwd.x = (wire_loc.x0 + wire_loc.x1) / 2;
             pwd.y = (wire_loc.y0 + wire_loc.y1) / 2;
 
+#ifdef ARCH_XILINX
+            wire_to_idx[ctx->getWireIndex(wire)] = int(flat_wires.size());
+#else
             wire_to_idx[wire] = int(flat_wires.size());
-            flat_wires.push_back(pwd);
+#endif
+            flat_wires.push_back(std::move(pwd));
         }
+        wire_visits.resize(flat_wires.size());
     }
 
+    // Queue entries only carry what the heap orders by; the driving pip and full score of a queued wire are in
+    // wire_visits, as a wire is never queued twice in one search
     struct QueuedWire
     {
-
-        explicit QueuedWire(int wire = -1, PipId pip = PipId(), Loc loc = Loc(), WireScore score = WireScore{},
-                            int randtag = 0)
-                : wire(wire), pip(pip), loc(loc), score(score), randtag(randtag){};
+        explicit QueuedWire(int wire = -1, float cost = 0, int randtag = 0)
+                : wire(wire), cost(cost), randtag(randtag){};
 
         int wire;
-        PipId pip;
-        Loc loc;
-        WireScore score;
+        float cost;
         int randtag = 0;
 
         struct Greater
         {
             bool operator()(const QueuedWire &lhs, const QueuedWire &rhs) const noexcept
             {
-                float lhs_score = lhs.score.cost + lhs.score.togo_cost,
-                      rhs_score = rhs.score.cost + rhs.score.togo_cost;
-                return lhs_score == rhs_score ? lhs.randtag > rhs.randtag : lhs_score > rhs_score;
+                return lhs.cost == rhs.cost ? lhs.randtag > rhs.randtag : lhs.cost > rhs.cost;
             }
         };
     };
 
+    struct WireQueue : std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater>
+    {
+        // Unlike swapping in a new queue, this keeps the allocation for the next search
+        void clear() { c.clear(); }
+    };
+
     bool hit_test_pip(ArcBounds &bb, Loc l) { return l.x >= bb.x0 && l.x <= bb.x1 && l.y >= bb.y0 && l.y <= bb.y1; }
 
     double curr_cong_weight, hist_cong_weight, estimate_weight;
+    // Amount curr_cong_weight is raised by after each iteration
+    float cong_step;
 
     struct ThreadContext
     {
@@ -266,10 +373,18 @@ struct Router2
 
         std::vector<int> route_arcs;
 
-        std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> queue;
+        WireQueue queue;
         // Special case where one net has multiple logical arcs to the same physical sink
         pool<WireId> processed_sinks;
 
+        // Wires of the current net's routing tree, that forward routing of further arcs can start from
+        std::vector<int> tree_wires;
+        pool<int> tree_set;
+        // The same wires bucketed by location, so that those near a sink can be found without scanning them all
+        dict<std::pair<int, int>, std::vector<int>> tree_buckets;
+        // Per arc of the current net, the area in which tree wires are used as search starting points
+        std::vector<ArcBounds> seed_bb;
+
         // Backwards routing
         std::queue<int> backwards_queue;
 
@@ -278,9 +393,35 @@ struct Router2
         // Thread bounding box
         ArcBounds bb;
 
+        // Wires expanded by route_arc so far
+        int64_t explored = 0;
+
+        // Scratch set for update_route_bb
+        pool<int> walked;
+
         DeterministicRNG rng;
     };
 
+    // Side in tiles of a tree_buckets bucket, and how many tree wires to seed an arc from once the tree is large
+    static const int tree_bucket_size = 4;
+    static const int max_tree_seeds = 32;
+
+    void add_tree_wire(ThreadContext &t, int wire)
+    {
+        if (t.tree_set.insert(wire).second) {
+            t.tree_wires.push_back(wire);
+            auto &wd = flat_wires.at(wire);
+            t.tree_buckets[std::make_pair(wd.x / tree_bucket_size, wd.y / tree_bucket_size)].push_back(wire);
+        }
+    }
+
+    void clear_tree(ThreadContext &t)
+    {
+        t.tree_wires.clear();
+        t.tree_set.clear();
+        t.tree_buckets.clear();
+    }
+
     bool thread_test_wire(ThreadContext &t, PerWireData &w)
     {
         return w.x >= t.bb.x0 && w.x <= t.bb.x1 && w.y >= t.bb.y0 && w.y <= t.bb.y1;
@@ -307,8 +448,29 @@ struct Router2
             log(__VA_ARGS__);                                                                                          \
     } while (0)
 
+    static void grow_bounds(ArcBounds &bb, int x, int y)
+    {
+        bb.x0 = std::min(bb.x0, x);
+        bb.y0 = std::min(bb.y0, y);
+        bb.x1 = std::max(bb.x1, x);
+        bb.y1 = std::max(bb.y1, y);
+    }
+
+    static ArcBounds merge_bounds(const ArcBounds &a, const ArcBounds &b)
+    {
+        if (a.x1 < a.x0 || a.y1 < a.y0)
+            return b;
+        if (b.x1 < b.x0 || b.y1 < b.y0)
+            return a;
+        return ArcBounds(std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1));
+    }
+
+    // Everything that routing the net may touch: its bounding box, and wherever its current routing is
+    ArcBounds net_route_box(const PerNetData &nd) { return merge_bounds(nd.bb, nd.route_bb); }
+
     void bind_pip_internal(NetInfo *net, size_t user, int wire, PipId pip)
     {
+        grow_bounds(nets.at(net->udata).route_bb, flat_wires.at(wire).x, flat_wires.at(wire).y);
         auto &b = flat_wires.at(wire).bound_nets[net->udata];
         ++b.first;
         if (b.first == 1) {
@@ -464,6 +626,114 @@ struct Router2
         return did_something;
     }
 
+    // Recomputes route_bb by walking the routed arcs, so that it shrinks again once the routing has moved back into
+    // the net's box (binding only ever grows it). Returns the box of the wires walked.
+    ArcBounds update_route_bb(NetInfo *net, pool<int> &walked)
+    {
+        auto &nd = nets.at(net->udata);
+        ArcBounds arc_bb(std::numeric_limits<int>::max(), std::numeric_limits<int>::max(),
+                         std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
+        walked.clear();
+        for (auto &ad : nd.arcs) {
+            if (!ad.routed)
+                continue;
+            WireId cursor = ad.sink_wire;
+            while (walked.insert(wire_idx(cursor)).second) {
+                auto &wd = wire_data(cursor);
+                grow_bounds(arc_bb, wd.x, wd.y);
+                if (cursor == nd.src_wire)
+                    break;
+                PipId pip = wd.bound_nets.at(net->udata).second;
+                if (pip == PipId())
+                    break;
+                cursor = ctx->getPipSrcWire(pip);
+            }
+        }
+        nd.route_bb = merge_bounds(nd.pinned_bb, arc_bb);
+        return arc_bb;
+    }
+
+    // Sets up route_bb and pinned_bb from the routing present before the main loop: bound by the Arch, adopted in
+    // ECO mode, or from the constant net pass
+    void init_route_bounds()
+    {
+        pool<int> walked;
+        for (auto net : nets_by_udata) {
+            auto &nd = nets.at(net->udata);
+            update_route_bb(net, walked);
+            for (auto &w : net->wires) {
+                int idx = wire_idx(w.first);
+                if (!walked.count(idx) && flat_wires.at(idx).bound_nets.count(net->udata))
+                    grow_bounds(nd.pinned_bb, flat_wires.at(idx).x, flat_wires.at(idx).y);
+            }
+            nd.route_bb = merge_bounds(nd.route_bb, nd.pinned_bb);
+        }
+    }
+
+    // Takes over the routing the design was loaded with. Arcs that still reach their sink count as routed, so that
+    // route_net keeps them and bind_and_check_all binds them again; nets with no arcs left to route are frozen.
+    void adopt_routing()
+    {
+        int frozen_nets = 0, eco_nets = 0, eco_arcs = 0, eco_outside = 0;
+        for (auto net : nets_by_udata) {
+            auto &nd = nets.at(net->udata);
+            // setup_wires counted every bound wire once; recount them by the arcs that use them, as route_arc would
+            for (auto &w : net->wires)
+                wire_data(w.first).bound_nets.at(net->udata).first = 0;
+            int unrouted = 0;
+            for (size_t i = 0; i < nd.arcs.size(); i++) {
+                auto &ad = nd.arcs.at(i);
+                if (ad.sink_wire == WireId() || nd.src_wire == WireId())
+                    continue;
+                if (!check_arc_routing(net, i)) {
+                    ++unrouted;
+                    continue;
+                }
+                WireId cursor = ad.sink_wire;
+                while (true) {
+                    auto &b = wire_data(cursor).bound_nets.at(net->udata);
+                    ++b.first;
+                    if (cursor == nd.src_wire || b.second == PipId())
+                        break;
+                    cursor = ctx->getPipSrcWire(b.second);
+                }
+                ad.routed = true;
+            }
+            for (auto &w : net->wires) {
+                auto &wd = wire_data(w.first);
+                if (wd.bound_nets.at(net->udata).first == 0) {
+                    if (w.second.strength > STRENGTH_STRONG)
+                        wd.bound_nets.at(net->udata).first = 1;
+                    else
+                        wd.bound_nets.erase(net->udata);
+                }
+            }
+            if (unrouted > 0) {
+                ++eco_nets;
+                eco_arcs += unrouted;
+                // The loaded routing may run anywhere. Where it leaves the net's box, init_route_bounds widens the
+                // area the net is scheduled by to cover it, so that no other net is routed alongside it there.
+                for (auto &w : net->wires) {
+                    auto &wd = wire_data(w.first);
+                    if (wd.bound_nets.count(net->udata) &&
+                        (wd.x < nd.bb.x0 || wd.x > nd.bb.x1 || wd.y < nd.bb.y0 || wd.y > nd.bb.y1)) {
+                        ++eco_outside;
+                        break;
+                    }
+                }
+                continue;
+            }
+            if (net->wires.empty())
+                continue;
+            nd.frozen = true;
+            ++frozen_nets;
+            for (auto &w : net->wires)
+                wire_data(w.first).unavailable = true;
+        }
+        log_info("    kept routing of %d nets; routing %d arcs of %d nets, %d with kept routing outside their box\n",
+                 frozen_nets, eco_arcs, eco_nets, eco_outside);
+    }
+
     void find_all_reserved_wires()
     {
         // Run iteratively, as reserving wires for one net might limit choices for another
@@ -483,17 +753,14 @@ struct Router2
     void reset_wires(ThreadContext &t)
     {
         for (auto w : t.dirty_wires) {
-            flat_wires[w].visit.visited = false;
-            flat_wires[w].visit.dirty = false;
-            flat_wires[w].visit.pip = PipId();
-            flat_wires[w].visit.score = WireScore();
+            wire_visits[w] = WireVisit();
         }
         t.dirty_wires.clear();
     }
 
     void set_visited(ThreadContext &t, int wire, PipId pip, WireScore score)
     {
-        auto &v = flat_wires.at(wire).visit;
+        auto &v = wire_visits.at(wire);
         if (!v.dirty)
             t.dirty_wires.push_back(wire);
         v.dirty = true;
@@ -501,7 +768,7 @@ struct Router2
         v.pip = pip;
         v.score = score;
     }
-    bool was_visited(int wire) { return flat_wires.at(wire).visit.visited; }
+    bool was_visited(int wire) { return wire_visits.at(wire).visited; }
 
 #ifdef ARCH_XILINX
     // Special-case constant ground/vcc routing for Xilinx devices
@@ -526,7 +793,7 @@ struct Router2
                 std::queue<int> new_queue;
                 t.backwards_queue.swap(new_queue);
             }
-            t.backwards_queue.push(wire_to_idx.at(dst_wire));
+            t.backwards_queue.push(wire_idx(dst_wire));
             reset_wires(t);
             while (!t.backwards_queue.empty() && backwards_iter < backwards_limit) {
                 int cursor = t.backwards_queue.front();
@@ -546,7 +813,7 @@ struct Router2
                         PipId p = flat_wires.at(cursor2).bound_nets.at(net->udata).second;
                         if (p == PipId())
                             break;
-                        cursor2 = wire_to_idx.at(ctx->getPipSrcWire(p));
+                        cursor2 = wire_idx(ctx->getPipSrcWire(p));
                     }
                     if (!bwd_merge_fail && cursor2 == src_wire_idx) {
                         // Found a path to merge to existing routing; backwards
@@ -555,7 +822,7 @@ struct Router2
                             PipId p = flat_wires.at(cursor2).bound_nets.at(net->udata).second;
                             if (p == PipId())
                                 break;
-                            cursor2 = wire_to_idx.at(ctx->getPipSrcWire(p));
+                            cursor2 = wire_idx(ctx->getPipSrcWire(p));
                             set_visited(t, cursor2, p, WireScore());
                         }
                         break;
@@ -582,7 +849,7 @@ struct Router2
                                 continue;
                             if (is_wire_undriveable(src, net))
                                 continue;
-                            cursor2 = wire_to_idx.at(src);
+                            cursor2 = wire_idx(src);
                             set_visited(t, cursor2, p, WireScore());
                             found = true;
                             break;
@@ -608,7 +875,7 @@ struct Router2
                         continue;
                     if (cpip != PipId() && cpip != uh)
                         continue; // don't allow multiple pips driving a wire with a net
-                    int next = wire_to_idx.at(ctx->getPipSrcWire(uh));
+                    int next = wire_idx(ctx->getPipSrcWire(uh));
                     if (was_visited(next))
                         continue; // skip wires that have already been visited
                     auto &wd = flat_wires[next];
@@ -625,14 +892,14 @@ struct Router2
                 if (did_something)
                     ++backwards_iter;
             }
-            int dst_wire_idx = wire_to_idx.at(dst_wire);
+            int dst_wire_idx = wire_idx(dst_wire);
             if (was_visited(src_wire_idx)) {
                 ROUTE_LOG_DBG("   Routed (backwards): ");
                 int cursor_fwd = src_wire_idx;
                 bind_pip_internal(net, i, src_wire_idx, PipId());
                 while (was_visited(cursor_fwd)) {
-                    auto &v = flat_wires.at(cursor_fwd).visit;
-                    cursor_fwd = wire_to_idx.at(ctx->getPipDstWire(v.pip));
+                    auto &v = wire_visits.at(cursor_fwd);
+                    cursor_fwd = wire_idx(ctx->getPipDstWire(v.pip));
                     bind_pip_internal(net, i, cursor_fwd, v.pip);
                     if (ctx->debug) {
                         auto &wd = flat_wires.at(cursor_fwd);
@@ -650,6 +917,140 @@ struct Router2
         log_error("Unrouteable %s sink %s.%s (%s)\n", ctx->nameOf(net), ctx->nameOf(net->users.at(i).cell),
                   ctx->nameOf(net->users.at(i).port), ctx->nameOfWire(dst_wire));
     }
+
+    // Find a path for a constant sink: a breadth-first search back to the nearest wire of the pseudo constant
+    // network, which is then followed up to the source. The path is returned from the source down, as wires with
+    // their driving pips. Only reads shared state, so that many sinks can be searched concurrently.
+    bool find_xilinx_const_path(NetInfo *net, bool const_val, int src_wire_idx, int dst_wire_idx,
+                                dict<int, PipId> &backtrace, std::vector<std::pair<int, PipId>> &path)
+    {
+        const int search_limit = 100000;
+        int pseudo_intent = const_val ? ID_PSEUDO_VCC : ID_PSEUDO_GND;
+        backtrace.clear();
+        path.clear();
+
+        std::queue<int> queue;
+        backtrace[dst_wire_idx] = PipId();
+        queue.push(dst_wire_idx);
+        int found = -1;
+        for (int iter = 0; !queue.empty() && iter < search_limit; iter++) {
+            int cursor = queue.front();
+            queue.pop();
+            auto &cwd = flat_wires.at(cursor);
+            if (cursor == src_wire_idx || ctx->wireIntent(cwd.w) == pseudo_intent) {
+                found = cursor;
+                break;
+            }
+            for (auto uh : ctx->getPipsUphill(cwd.w)) {
+                if (!ctx->checkPipAvail(uh) && ctx->getBoundPipNet(uh) != net)
+                    continue;
+                int next = wire_idx(ctx->getPipSrcWire(uh));
+                if (backtrace.count(next))
+                    continue;
+                auto &wd = flat_wires.at(next);
+                if (wd.unavailable || (wd.reserved_net != -1 && wd.reserved_net != net->udata))
+                    continue;
+                if (!wd.bound_nets.empty() && (wd.bound_nets.size() > 1 || !wd.bound_nets.count(net->udata)))
+                    continue;
+                backtrace[next] = uh;
+                queue.push(next);
+            }
+        }
+        if (found == -1)
+            return false;
+
+        // Up the pseudo network, bounded in case it contains a loop
+        std::vector<std::pair<int, PipId>> up;
+        for (int cursor = found; cursor != src_wire_idx;) {
+            PipId drv;
+            for (auto p : ctx->getPipsUphill(flat_wires.at(cursor).w)) {
+                if (!ctx->checkPipAvail(p) && ctx->getBoundPipNet(p) != net)
+                    continue;
+                WireId src = ctx->getPipSrcWire(p);
+                if (ctx->wireIntent(src) != pseudo_intent || is_wire_undriveable(src, net))
+                    continue;
+                drv = p;
+                break;
+            }
+            if (drv == PipId() || up.size() > size_t(search_limit))
+                return false;
+            up.emplace_back(cursor, drv);
+            cursor = wire_idx(ctx->getPipSrcWire(drv));
+        }
+
+        path.emplace_back(src_wire_idx, PipId());
+        path.insert(path.end(), up.rbegin(), up.rend());
+        for (int cursor = found; cursor != dst_wire_idx;) {
+            PipId pip = backtrace.at(cursor);
+            cursor = wire_idx(ctx->getPipDstWire(pip));
+            path.emplace_back(cursor, pip);
+        }
+        return true;
+    }
+
+    // Route the sinks of the constant nets before the main loop. Paths are searched in parallel against the initial
+    // state and then bound in arc order, skipping any that disagree with a path bound before them; those are left to
+    // route_xilinx_const in the main loop.
+    void route_xilinx_const_nets()
+    {
+        struct ConstArc
+        {
+            NetInfo *net;
+            size_t user;
+            bool const_val;
+            std::vector<std::pair<int, PipId>> path;
+        };
+        std::vector<ConstArc> arcs;
+        for (auto net : nets_by_udata) {
+            bool const_val = (net->name == ctx->id("$PACKER_VCC_NET"));
+            if (!const_val && net->name != ctx->id("$PACKER_GND_NET"))
+                continue;
+            if (nets.at(net->udata).src_wire == WireId())
+                continue;
+            for (size_t i = 0; i < net->users.size(); i++) {
+                WireId sink = nets.at(net->udata).arcs.at(i).sink_wire;
+                if (sink != WireId() && sink != nets.at(net->udata).src_wire && !check_arc_routing(net, i))
+                    arcs.push_back(ConstArc{net, i, const_val, {}});
+            }
+        }
+        if (arcs.empty())
+            return;
+
+        std::atomic<size_t> next_arc(0);
+        auto worker = [&]() {
+            dict<int, PipId> backtrace;
+            for (size_t j = next_arc++; j < arcs.size(); j = next_arc++) {
+                auto &ca = arcs.at(j);
+                auto &nd = nets.at(ca.net->udata);
+                find_xilinx_const_path(ca.net, ca.const_val, wire_idx(nd.src_wire),
+                                       wire_idx(nd.arcs.at(ca.user).sink_wire), backtrace, ca.path);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < std::min(cfg.thread_count, int(arcs.size())); i++)
+            threads.emplace_back(worker);
+        for (auto &t : threads)
+            t.join();
+
+        int routed = 0;
+        for (auto &ca : arcs) {
+            if (ca.path.empty())
+                continue;
+            bool conflict = false;
+            for (auto &step : ca.path) {
+                for (auto &bound : flat_wires.at(step.first).bound_nets)
+                    if (bound.first != ca.net->udata || bound.second.second != step.second)
+                        conflict = true;
+            }
+            if (conflict)
+                continue;
+            for (auto &step : ca.path)
+                bind_pip_internal(ca.net, ca.user, step.first, step.second);
+            nets.at(ca.net->udata).arcs.at(ca.user).routed = true;
+            ++routed;
+        }
+        log_info("    routed %d/%d constant sinks\n", routed, int(arcs.size()));
+    }
 #endif
 
     ArcRouteResult route_arc(ThreadContext &t, NetInfo *net, size_t i, bool is_mt, bool is_bb = true)
@@ -667,8 +1068,8 @@ struct Router2
         if (dst_wire == WireId())
             ARC_LOG_ERR("No wire found for port %s on destination cell %s.\n", ctx->nameOf(usr.port),
                         ctx->nameOf(usr.cell));
-        int src_wire_idx = wire_to_idx.at(src_wire);
-        int dst_wire_idx = wire_to_idx.at(dst_wire);
+        int src_wire_idx = wire_idx(src_wire);
+        int dst_wire_idx = wire_idx(dst_wire);
         // Check if arc was already done _in this iteration_
         if (t.processed_sinks.count(dst_wire))
             return ARC_SUCCESS;
@@ -681,10 +1082,7 @@ struct Router2
         }
 #endif
 
-        if (!t.queue.empty()) {
-            std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> new_queue;
-            t.queue.swap(new_queue);
-        }
+        t.queue.clear();
         if (!t.backwards_queue.empty()) {
             std::queue<int> new_queue;
             t.backwards_queue.swap(new_queue);
@@ -695,10 +1093,11 @@ struct Router2
         // This could also be used to speed up forwards routing by a hybrid
         // bidirectional approach
         int backwards_iter = 0;
+        bool high_fanout = int(net->users.size()) > cfg.high_fanout_threshold;
         int backwards_limit = ctx->getBelGlobalBuf(net->driver.cell->bel)
                                       ? cfg.global_backwards_max_iter
-                                      : (net->users.size() > 40 ? 20 * cfg.backwards_max_iter : cfg.backwards_max_iter);
-        t.backwards_queue.push(wire_to_idx.at(dst_wire));
+                                      : (high_fanout ? 20 * cfg.backwards_max_iter : cfg.backwards_max_iter);
+        t.backwards_queue.push(wire_idx(dst_wire));
         while (!t.backwards_queue.empty() && backwards_iter < backwards_limit) {
             int cursor = t.backwards_queue.front();
             t.backwards_queue.pop();
@@ -713,7 +1112,7 @@ struct Router2
                     PipId p = flat_wires.at(cursor2).bound_nets.at(net->udata).second;
                     if (p == PipId())
                         break;
-                    cursor2 = wire_to_idx.at(ctx->getPipSrcWire(p));
+                    cursor2 = wire_idx(ctx->getPipSrcWire(p));
                 }
                 if (!bwd_merge_fail && cursor2 == src_wire_idx) {
                     // Found a path to merge to existing routing; backwards
@@ -722,7 +1121,7 @@ struct Router2
                         PipId p = flat_wires.at(cursor2).bound_nets.at(net->udata).second;
                         if (p == PipId())
                             break;
-                        cursor2 = wire_to_idx.at(ctx->getPipSrcWire(p));
+                        cursor2 = wire_idx(ctx->getPipSrcWire(p));
                         set_visited(t, cursor2, p, WireScore());
                     }
                     break;
@@ -736,7 +1135,7 @@ struct Router2
                     continue;
                 if (cpip != PipId() && cpip != uh)
                     continue; // don't allow multiple pips driving a wire with a net
-                int next = wire_to_idx.at(ctx->getPipSrcWire(uh));
+                int next = wire_idx(ctx->getPipSrcWire(uh));
                 if (was_visited(next))
                     continue; // skip wires that have already been visited
                 auto &wd = flat_wires[next];
@@ -759,10 +1158,12 @@ struct Router2
             ROUTE_LOG_DBG("   Routed (backwards): ");
             int cursor_fwd = src_wire_idx;
             bind_pip_internal(net, i, src_wire_idx, PipId());
+            add_tree_wire(t, src_wire_idx);
             while (was_visited(cursor_fwd)) {
-                auto &v = flat_wires.at(cursor_fwd).visit;
-                cursor_fwd = wire_to_idx.at(ctx->getPipDstWire(v.pip));
+                auto &v = wire_visits.at(cursor_fwd);
+                cursor_fwd = wire_idx(ctx->getPipDstWire(v.pip));
                 bind_pip_internal(net, i, cursor_fwd, v.pip);
+                add_tree_wire(t, cursor_fwd);
                 if (ctx->debug) {
                     auto &wd = flat_wires.at(cursor_fwd);
                     ROUTE_LOG_DBG("      wire: %s (curr %d hist %f)\n", ctx->nameOfWire(wd.w),
@@ -784,8 +1185,61 @@ struct Router2
         base_score.togo_cost = get_togo_cost(net, i, src_wire_idx, dst_wire);
 
         // Add source wire to queue
-        t.queue.push(QueuedWire(src_wire_idx, PipId(), Loc(), base_score));
+        t.queue.push(QueuedWire(src_wire_idx, base_score.total()));
         set_visited(t, src_wire_idx, PipId(), base_score);
+        // Also start from the routing the net already has near this arc, so that only the branch to the sink has to
+        // be searched. Not for critical arcs, where a long existing path may be slower than a new one.
+        if (ad.arc_crit < 0.8) {
+            const ArcBounds &sbb = t.seed_bb.at(i);
+            int seeds = 0;
+            auto add_seed = [&](int tw) {
+                auto &twd = flat_wires.at(tw);
+                if (tw == src_wire_idx || was_visited(tw) || !thread_test_wire(t, twd) || twd.x < sbb.x0 ||
+                    twd.x > sbb.x1 || twd.y < sbb.y0 || twd.y > sbb.y1)
+                    return;
+                WireScore tree_score;
+                tree_score.cost = 0;
+                tree_score.delay = 0;
+                tree_score.togo_cost = cfg.estimate_weight * get_togo_cost(net, i, tw, dst_wire);
+                t.queue.push(QueuedWire(tw, tree_score.total(), t.rng.rng()));
+                set_visited(t, tw, PipId(), tree_score);
+                ++seeds;
+            };
+            if (int(t.tree_wires.size()) <= 4 * max_tree_seeds) {
+                for (int tw : t.tree_wires)
+                    add_seed(tw);
+            } else {
+                // On large trees, only take the wires nearest the sink: search rings of buckets outwards from it
+                // until enough have been found, so that the cost per arc doesn't grow with the size of the tree
+                int bx0 = std::max(sbb.x0, t.bb.x0) / tree_bucket_size;
+                int by0 = std::max(sbb.y0, t.bb.y0) / tree_bucket_size;
+                int bx1 = std::min(sbb.x1, t.bb.x1) / tree_bucket_size;
+                int by1 = std::min(sbb.y1, t.bb.y1) / tree_bucket_size;
+                auto &dwd = flat_wires.at(dst_wire_idx);
+                int cx = std::max(bx0, std::min(bx1, dwd.x / tree_bucket_size));
+                int cy = std::max(by0, std::min(by1, dwd.y / tree_bucket_size));
+                auto visit_bucket = [&](int bx, int by) {
+                    if (bx < bx0 || bx > bx1 || by < by0 || by > by1)
+                        return;
+                    auto fnd = t.tree_buckets.find(std::make_pair(bx, by));
+                    if (fnd != t.tree_buckets.end())
+                        for (int tw : fnd->second)
+                            add_seed(tw);
+                };
+                int max_r = std::max(std::max(cx - bx0, bx1 - cx), std::max(cy - by0, by1 - cy));
+                for (int r = 0; r <= max_r && seeds < max_tree_seeds; r++) {
+                    for (int d = -r; d <= r; d++) {
+                        visit_bucket(cx + d, cy - r);
+                        if (r > 0)
+                            visit_bucket(cx + d, cy + r);
+                    }
+                    for (int d = -r + 1; d < r; d++) {
+                        visit_bucket(cx - r, cy + d);
+                        visit_bucket(cx + r, cy + d);
+                    }
+                }
+            }
+        }
 
         int toexplore = 250000 * std::max(1, (ad.bb.x1 - ad.bb.x0) + (ad.bb.y1 - ad.bb.y0));
         int iter = 0;
@@ -807,8 +1261,10 @@ struct Router2
         while (!t.queue.empty() && (must_drain_queue || iter < toexplore)) {
             auto curr = t.queue.top();
             auto &d = flat_wires.at(curr.wire);
+            const WireScore curr_score = wire_visits.at(curr.wire).score;
             t.queue.pop();
             ++iter;
+            ++t.explored;
 #if 0
             ROUTE_LOG_DBG("current wire %s\n", ctx->nameOfWire(d.w));
 #endif
@@ -830,7 +1286,7 @@ struct Router2
 #endif
                 // Evaluate score of next wire
                 WireId next = ctx->getPipDstWire(dh);
-                int next_idx = wire_to_idx.at(next);
+                int next_idx = wire_idx(next);
                 if (was_visited(next_idx))
                     continue;
 #if 1
@@ -847,11 +1303,11 @@ struct Router2
                 if (!thread_test_wire(t, nwd))
                     continue; // thread safety issue
                 WireScore next_score;
-                next_score.cost = curr.score.cost + score_wire_for_arc(net, i, next, dh);
+                next_score.cost = curr_score.cost + score_wire_for_arc(net, i, next, dh);
                 next_score.delay =
-                        curr.score.delay + ctx->getPipDelay(dh).maxDelay() + ctx->getWireDelay(next).maxDelay();
+                        curr_score.delay + ctx->getPipDelay(dh).maxDelay() + ctx->getWireDelay(next).maxDelay();
                 next_score.togo_cost = cfg.estimate_weight * get_togo_cost(net, i, next_idx, dst_wire);
-                const auto &v = nwd.visit;
+                const auto &v = wire_visits.at(next_idx);
                 if (!v.visited || (v.score.total() > next_score.total())) {
                     ++explored;
 #if 0
@@ -859,7 +1315,7 @@ struct Router2
                                   next_score.togo_cost);
 #endif
                     // Add wire to queue if it meets criteria
-                    t.queue.push(QueuedWire(next_idx, dh, ctx->getPipLocation(dh), next_score, t.rng.rng()));
+                    t.queue.push(QueuedWire(next_idx, next_score.total(), t.rng.rng()));
                     set_visited(t, next_idx, dh, next_score);
                     if (next == dst_wire) {
                         toexplore = std::min(toexplore, iter + 5);
@@ -871,22 +1327,29 @@ struct Router2
         if (was_visited(dst_wire_idx)) {
             ROUTE_LOG_DBG("   Routed (explored %d wires): ", explored);
             int cursor_bwd = dst_wire_idx;
-            while (was_visited(cursor_bwd)) {
-                auto &v = flat_wires.at(cursor_bwd).visit;
-                bind_pip_internal(net, i, cursor_bwd, v.pip);
+            while (true) {
+                PipId pip;
+                if (was_visited(cursor_bwd))
+                    pip = wire_visits.at(cursor_bwd).pip;
+                if (pip == PipId() && cursor_bwd != src_wire_idx) {
+                    // Joined the existing routing of this net, follow it back to the source
+                    pip = flat_wires.at(cursor_bwd).bound_nets.at(net->udata).second;
+                }
+                bind_pip_internal(net, i, cursor_bwd, pip);
+                add_tree_wire(t, cursor_bwd);
                 if (ctx->debug) {
                     auto &wd = flat_wires.at(cursor_bwd);
                     ROUTE_LOG_DBG("      wire: %s (curr %d hist %f share %d)\n", ctx->nameOfWire(wd.w),
                                   int(wd.bound_nets.size()) - 1, wd.hist_cong_cost,
                                   wd.bound_nets.count(net->udata) ? wd.bound_nets.at(net->udata).first : 0);
                 }
-                if (v.pip == PipId()) {
+                if (pip == PipId()) {
                     NPNR_ASSERT(cursor_bwd == src_wire_idx);
                     break;
                 }
-                ROUTE_LOG_DBG("         pip: %s (%d, %d)\n", ctx->nameOfPip(v.pip), ctx->getPipLocation(v.pip).x,
-                              ctx->getPipLocation(v.pip).y);
-                cursor_bwd = wire_to_idx.at(ctx->getPipSrcWire(v.pip));
+                ROUTE_LOG_DBG("         pip: %s (%d, %d)\n", ctx->nameOfPip(pip), ctx->getPipLocation(pip).x,
+                              ctx->getPipLocation(pip).y);
+                cursor_bwd = wire_idx(ctx->getPipSrcWire(pip));
             }
             t.processed_sinks.insert(dst_wire);
             ad.routed = true;
@@ -899,6 +1362,79 @@ struct Router2
     }
 #undef ARC_ERR
 
+    // For high fanout nets, route the arcs in the order of a minimum spanning tree over the sinks, rooted at the
+    // existing routing. Each arc then only has to branch off the routing of a nearby sink routed before it, so the
+    // net grows as a Steiner-like tree rather than as a bundle of paths from the source.
+    void order_arcs_by_skeleton(ThreadContext &t, NetInfo *net)
+    {
+        // Prim's algorithm is quadratic in the number of arcs; beyond this, just route outwards from the tree
+        const size_t max_prim_arcs = 4096;
+        auto &nd = nets.at(net->udata);
+        size_t k = t.route_arcs.size();
+        std::vector<Loc> locs(k), parent(k);
+        std::vector<int> dist(k);
+        auto manhattan = [](const Loc &a, const Loc &b) { return std::abs(a.x - b.x) + std::abs(a.y - b.y); };
+        for (size_t j = 0; j < k; j++) {
+            auto &swd = wire_data(nd.arcs.at(t.route_arcs.at(j)).sink_wire);
+            locs.at(j) = Loc(swd.x, swd.y, 0);
+            dist.at(j) = std::numeric_limits<int>::max();
+        }
+        // Root the skeleton at the source, and also at the rest of the routing when that is affordable
+        const size_t max_root_checks = 10000000;
+        std::vector<int> roots(1, wire_idx(nd.src_wire));
+        if (!t.tree_wires.empty() && t.tree_wires.size() * k <= max_root_checks)
+            roots = t.tree_wires;
+        for (int tw : roots) {
+            Loc tl(flat_wires.at(tw).x, flat_wires.at(tw).y, 0);
+            for (size_t j = 0; j < k; j++) {
+                int d = manhattan(locs.at(j), tl);
+                if (d < dist.at(j)) {
+                    dist.at(j) = d;
+                    parent.at(j) = tl;
+                }
+            }
+        }
+
+        std::vector<int> order;
+        if (k > max_prim_arcs) {
+            for (size_t j = 0; j < k; j++)
+                order.push_back(int(j));
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return dist.at(a) < dist.at(b); });
+        } else {
+            std::vector<bool> done(k, false);
+            for (size_t n = 0; n < k; n++) {
+                int next = -1;
+                for (size_t j = 0; j < k; j++)
+                    if (!done.at(j) && (next == -1 || dist.at(j) < dist.at(next)))
+                        next = int(j);
+                done.at(next) = true;
+                order.push_back(next);
+                for (size_t j = 0; j < k; j++) {
+                    int d = manhattan(locs.at(j), locs.at(next));
+                    if (!done.at(j) && d < dist.at(j)) {
+                        dist.at(j) = d;
+                        parent.at(j) = locs.at(next);
+                    }
+                }
+            }
+        }
+
+        std::vector<int> ordered_arcs;
+        for (int j : order) {
+            int arc = t.route_arcs.at(j);
+            ordered_arcs.push_back(arc);
+            // Start from tree wires between the sink and its parent in the skeleton
+            if (dist.at(j) == std::numeric_limits<int>::max())
+                continue;
+            auto &sbb = t.seed_bb.at(arc);
+            sbb.x0 = std::min(locs.at(j).x, parent.at(j).x) - cfg.bb_margin_x;
+            sbb.y0 = std::min(locs.at(j).y, parent.at(j).y) - cfg.bb_margin_y;
+            sbb.x1 = std::max(locs.at(j).x, parent.at(j).x) + cfg.bb_margin_x;
+            sbb.y1 = std::max(locs.at(j).y, parent.at(j).y) + cfg.bb_margin_y;
+        }
+        t.route_arcs = ordered_arcs;
+    }
+
     bool route_net(ThreadContext &t, NetInfo *net, bool is_mt)
     {
 
@@ -910,6 +1446,7 @@ struct Router2
         ROUTE_LOG_DBG("Routing net '%s'...\n", ctx->nameOf(net));
 
         auto rstart = std::chrono::high_resolution_clock::now();
+        int64_t explored_before = t.explored;
 
         // Nothing to do if net is undriven
         if (net->driver.cell == nullptr)
@@ -932,6 +1469,29 @@ struct Router2
             ripup_arc(net, i);
             t.route_arcs.push_back(i);
         }
+        // Collect what is left of the routing tree, which the ripped up arcs can branch off again. Only wires in the
+        // thread's box can be used as seeds, so the walk stops at its edge.
+        clear_tree(t);
+        WireId src_wire = nets.at(net->udata).src_wire;
+        for (auto &ad : nets.at(net->udata).arcs) {
+            if (!ad.routed)
+                continue;
+            WireId cursor = ad.sink_wire;
+            while (!t.tree_set.count(wire_idx(cursor)) && thread_test_wire(t, wire_data(cursor))) {
+                add_tree_wire(t, wire_idx(cursor));
+                if (cursor == src_wire)
+                    break;
+                PipId pip = wire_data(cursor).bound_nets.at(net->udata).second;
+                if (pip == PipId())
+                    break;
+                cursor = ctx->getPipSrcWire(pip);
+            }
+        }
+        t.seed_bb.resize(net->users.size());
+        for (size_t i = 0; i < net->users.size(); i++)
+            t.seed_bb.at(i) = nets.at(net->udata).arcs.at(i).bb;
+        if (int(net->users.size()) > cfg.high_fanout_threshold && t.route_arcs.size() > 1)
+            order_arcs_by_skeleton(t, net);
         for (auto i : t.route_arcs) {
             auto res1 = route_arc(t, net, i, is_mt, true);
             if (res1 == ARC_FATAL)
@@ -953,11 +1513,12 @@ struct Router2
                 }
             }
         }
-        if (cfg.perf_profile) {
-            auto rend = std::chrono::high_resolution_clock::now();
-            nets.at(net->udata).total_route_us +=
-                    (std::chrono::duration_cast<std::chrono::microseconds>(rend - rstart).count());
-        }
+        auto rend = std::chrono::high_resolution_clock::now();
+        int route_us = int(std::chrono::duration_cast<std::chrono::microseconds>(rend - rstart).count());
+        nets.at(net->udata).last_explored = t.explored - explored_before;
+        update_route_bb(net, t.walked);
+        if (cfg.perf_profile)
+            nets.at(net->udata).total_route_us += route_us;
         return !have_failures;
     }
 #undef ROUTE_LOG_DBG
@@ -974,6 +1535,8 @@ struct Router2
         overused_wires = 0;
         total_wire_use = 0;
         failed_nets.clear();
+        for (auto &net_data : nets)
+            net_data.overuse = 0;
         for (auto &wire : flat_wires) {
             total_wire_use += int(wire.bound_nets.size());
             int overuse = int(wire.bound_nets.size()) - 1;
@@ -981,8 +1544,10 @@ struct Router2
                 wire.hist_cong_cost += overuse * hist_cong_weight;
                 total_overuse += overuse;
                 overused_wires += 1;
-                for (auto &bound : wire.bound_nets)
+                for (auto &bound : wire.bound_nets) {
                     failed_nets.insert(bound.first);
+                    nets.at(bound.first).overuse += overuse;
+                }
             }
         }
         for (int n : failed_nets) {
@@ -1074,9 +1639,45 @@ struct Router2
         return success;
     }
 
+    // Timing analysis only sees the Arch bindings, which only change in bind_and_check_all; until then the
+    // criticalities stored per arc remain valid and STA doesn't need to be re-run
+    bool timing_dirty = true;
+
+    void update_criticalities()
+    {
+        if (!timing_dirty)
+            return;
+        get_criticalities(ctx, &net_crit);
+        for (size_t n = 0; n < nets.size(); n++) {
+            auto fnd = net_crit.find(nets_by_udata.at(n)->name);
+            auto &net = nets.at(n);
+            net.max_crit = 0;
+            for (size_t i = 0; i < net.arcs.size(); i++) {
+                float c = 0;
+                if (fnd != net_crit.end() && i < fnd->second.criticality.size())
+                    c = fnd->second.criticality.at(i);
+                net.arcs.at(i).arc_crit = c;
+                net.max_crit = std::max(net.max_crit, c);
+            }
+        }
+        timing_dirty = false;
+    }
+
+    // Whether criticalities were updated for the current iteration's route queue; they aren't when STA is skipped,
+    // and are then left out of the net order rather than using stale values
+    bool crit_ordered = false;
+
+    // Criticality that the route queue is ordered by: nets below the threshold count as equally (non-)critical
+    float queue_crit(int net) const
+    {
+        float crit = nets.at(net).max_crit;
+        return (crit_ordered && crit >= cfg.critical_threshold) ? crit : 0;
+    }
+
     int arch_fail = 0;
     bool bind_and_check_all()
     {
+        timing_dirty = true;
         bool success = true;
         std::vector<WireId> net_wires;
         for (auto net : nets_by_udata) {
@@ -1084,6 +1685,8 @@ struct Router2
             if (net->is_global)
                 continue;
 #endif
+            if (nets.at(net->udata).frozen)
+                continue;
             // Ripup wires and pips used by the net in nextpnr's structures
             net_wires.clear();
             for (auto &w : net->wires) {
@@ -1140,51 +1743,148 @@ struct Router2
             out << std::endl;
         }
     }
-    int mid_x = 0, mid_y = 0;
+    // Routing regions form a binary tree built by recursive bisection. The two children of a region are disjoint, so
+    // all the regions at one depth can be routed concurrently. Each net is routed in the deepest region that contains
+    // its bounding box; the root (the whole device) is routed single-threaded.
+    struct Partition
+    {
+        ArcBounds bb;
+        int depth = 0;
+        // The lower child covers coordinates up to and including split on the split axis, the upper child the rest
+        bool split_x = false;
+        int split = -1;
+        int parent = -1;
+        int children[2] = {-1, -1};
+    };
+    std::vector<Partition> partitions;
 
-    void partition_nets()
+    // Estimated routing effort of a net, used to balance the partitions
+    int64_t net_work(const PerNetData &nd)
+    {
+        if (nd.bb.x1 < nd.bb.x0 || nd.bb.y1 < nd.bb.y0)
+            return 0;
+        return int64_t(nd.arcs.size()) * (nd.bb.x1 - nd.bb.x0 + 1) * (nd.bb.y1 - nd.bb.y0 + 1);
+    }
+
+    // Which child of a split region a bounding box fits into, with one tile of slack; or -1 if it crosses the split
+    int partition_side(const Partition &p, const ArcBounds &bb)
     {
-        // Create a histogram of positions in X and Y positions
-        std::map<int, int> cxs, cys;
-        for (auto &n : nets) {
-            if (n.cx != -1)
-                ++cxs[n.cx];
-            if (n.cy != -1)
-                ++cys[n.cy];
-        }
-        // 4-way split for now
-        int accum_x = 0, accum_y = 0;
-        int halfway = int(nets.size()) / 2;
-        for (auto &p : cxs) {
-            if (accum_x < halfway && (accum_x + p.second) >= halfway)
-                mid_x = p.first;
-            accum_x += p.second;
-        }
-        for (auto &p : cys) {
-            if (accum_y < halfway && (accum_y + p.second) >= halfway)
-                mid_y = p.first;
-            accum_y += p.second;
+        int lo = p.split_x ? bb.x0 : bb.y0, hi = p.split_x ? bb.x1 : bb.y1;
+        if (hi < p.split)
+            return 0;
+        if (lo > p.split + 1)
+            return 1;
+        return -1;
+    }
+
+    int partition_for(const ArcBounds &bb)
+    {
+        int idx = 0;
+        while (partitions.at(idx).split != -1) {
+            int side = partition_side(partitions.at(idx), bb);
+            if (side == -1)
+                break;
+            idx = partitions.at(idx).children[side];
         }
-        if (ctx->verbose) {
-            log_info("    x splitpoint: %d\n", mid_x);
-            log_info("    y splitpoint: %d\n", mid_y);
-        }
-        std::vector<int> bins(5, 0);
-        for (auto &n : nets) {
-            if (n.bb.x0 < mid_x && n.bb.x1 < mid_x && n.bb.y0 < mid_y && n.bb.y1 < mid_y)
-                ++bins[0]; // TL
-            else if (n.bb.x0 >= mid_x && n.bb.x1 >= mid_x && n.bb.y0 < mid_y && n.bb.y1 < mid_y)
-                ++bins[1]; // TR
-            else if (n.bb.x0 < mid_x && n.bb.x1 < mid_x && n.bb.y0 >= mid_y && n.bb.y1 >= mid_y)
-                ++bins[2]; // BL
-            else if (n.bb.x0 >= mid_x && n.bb.x1 >= mid_x && n.bb.y0 >= mid_y && n.bb.y1 >= mid_y)
-                ++bins[3]; // BR
+        return idx;
+    }
+
+    void split_partition(int idx, const std::vector<int> &region_nets)
+    {
+        if (partitions.at(idx).depth >= cfg.partition_depth || region_nets.size() < 2)
+            return;
+        // Split at the work-weighted median of net centres, on whichever axis leaves less work crossing the split
+        Partition best = partitions.at(idx);
+        int64_t best_crossing = std::numeric_limits<int64_t>::max();
+        std::vector<std::pair<int, int64_t>> centres;
+        for (bool split_x : {true, false}) {
+            const ArcBounds &rbb = partitions.at(idx).bb;
+            int lo = split_x ? rbb.x0 : rbb.y0, hi = split_x ? rbb.x1 : rbb.y1;
+            if (hi <= lo)
+                continue;
+            centres.clear();
+            int64_t total = 0;
+            for (int n : region_nets) {
+                auto &nd = nets.at(n);
+                centres.emplace_back(split_x ? nd.cx : nd.cy, net_work(nd));
+                total += centres.back().second;
+            }
+            std::sort(centres.begin(), centres.end());
+            int64_t accum = 0;
+            int split = centres.back().first;
+            for (auto &c : centres) {
+                accum += c.second;
+                if (2 * accum >= total) {
+                    split = c.first;
+                    break;
+                }
+            }
+            Partition trial = partitions.at(idx);
+            trial.split_x = split_x;
+            trial.split = std::min(std::max(split, lo), hi - 1);
+            int64_t crossing = 0;
+            for (int n : region_nets)
+                if (partition_side(trial, nets.at(n).bb) == -1)
+                    crossing += net_work(nets.at(n));
+            if (crossing < best_crossing) {
+                best_crossing = crossing;
+                best = trial;
+            }
+        }
+        if (best.split == -1)
+            return;
+
+        std::vector<int> child_nets[2];
+        for (int n : region_nets) {
+            int side = partition_side(best, nets.at(n).bb);
+            if (side != -1)
+                child_nets[side].push_back(n);
+        }
+        for (int side = 0; side < 2; side++) {
+            Partition child;
+            child.bb = best.bb;
+            child.depth = best.depth + 1;
+            child.parent = idx;
+            if (best.split_x)
+                (side == 0 ? child.bb.x1 : child.bb.x0) = best.split + side;
             else
-                ++bins[4]; // cross-boundary
+                (side == 0 ? child.bb.y1 : child.bb.y0) = best.split + side;
+            best.children[side] = int(partitions.size());
+            partitions.push_back(child);
+        }
+        partitions.at(idx) = best;
+        for (int side = 0; side < 2; side++)
+            split_partition(best.children[side], child_nets[side]);
+    }
+
+    void partition_nets()
+    {
+        // The depth is fixed rather than derived from the thread count, so that the partitioning, and so the result,
+        // is the same on any machine; the regions are shared out between however many threads there are.
+        partitions.clear();
+        partitions.emplace_back();
+        partitions.back().bb = ArcBounds(0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+        std::vector<int> all_nets;
+        for (int i = 0; i < int(nets.size()); i++)
+            if (!nets.at(i).frozen && net_work(nets.at(i)) > 0)
+                all_nets.push_back(i);
+        split_partition(0, all_nets);
+
+        if (ctx->verbose) {
+            std::vector<int> bins(partitions.size(), 0);
+            for (int n : all_nets)
+                ++bins.at(partition_for(nets.at(n).bb));
+            log_info("    %d routing regions for %d threads\n", int(partitions.size()), cfg.thread_count);
+            for (size_t i = 0; i < partitions.size(); i++) {
+                auto &p = partitions.at(i);
+                if (p.split == -1 || i == 0)
+                    log_info("        region %d depth %d (%d, %d)->(%d, %d) N=%d\n", int(i), p.depth, p.bb.x0,
+                             p.bb.y0, p.bb.x1, p.bb.y1, bins.at(i));
+                else
+                    log_info("        region %d depth %d split %c=%d N=%d\n", int(i), p.depth, p.split_x ? 'x' : 'y',
+                             p.split, bins.at(i));
+            }
         }
-        if (ctx->verbose)
-            for (int i = 0; i < 5; i++)
-                log_info("        bin %d N=%d\n", i, bins[i]);
     }
 
     void router_thread(ThreadContext &t)
@@ -1196,10 +1896,99 @@ struct Router2
         }
     }
 
+    // Stamp per tile of the batch whose bounding boxes cover it, for route_tail
+    std::vector<int> tail_grid;
+
+    // Nets that cross region boundaries are routed in batches whose bounding boxes are disjoint. Such nets can't
+    // touch the same wires, so a batch can be routed concurrently; nets that need to leave their box, and the
+    // leftovers once batches get too small to be worth it, are routed single-threaded.
+    void route_tail(ThreadContext &st)
+    {
+        const int min_batch = 4;
+        int dim_x = ctx->getGridDimX() + 1, dim_y = ctx->getGridDimY() + 1;
+        tail_grid.assign(size_t(dim_x) * dim_y, -1);
+
+        std::vector<NetInfo *> tail, remaining, batch, serial;
+        // Nets spanning a large part of the device would end up alone in a batch anyway
+        for (auto ni : st.route_nets) {
+            auto bb = net_route_box(nets.at(ni->udata));
+            if (int64_t(bb.x1 - bb.x0 + 1) * (bb.y1 - bb.y0 + 1) * 4 > int64_t(dim_x) * dim_y)
+                serial.push_back(ni);
+            else
+                tail.push_back(ni);
+        }
+        for (auto ni : serial)
+            route_net(st, ni, false);
+
+        std::vector<ThreadContext> tcs(cfg.thread_count);
+        std::vector<uint64_t> seeds;
+        for (int stamp = 0; !tail.empty(); stamp++) {
+            batch.clear();
+            remaining.clear();
+            for (auto ni : tail) {
+                auto &nd = nets.at(ni->udata);
+                if (nd.bb.x1 < nd.bb.x0 || nd.bb.y1 < nd.bb.y0) {
+                    // No arcs to route
+                    batch.push_back(ni);
+                    continue;
+                }
+                // New routing stays in the net's own box, but its existing routing, which is ripped up and checked,
+                // may lie outside it; both are kept clear of the other nets in the batch. Keep a tile of space
+                // between boxes, as wire and pip locations can differ slightly.
+                auto bb = net_route_box(nd);
+                bool overlaps = false;
+                for (int y = std::max(bb.y0 - 1, 0); y <= std::min(bb.y1 + 1, dim_y - 1) && !overlaps; y++)
+                    for (int x = std::max(bb.x0 - 1, 0); x <= std::min(bb.x1 + 1, dim_x - 1) && !overlaps; x++)
+                        overlaps = (tail_grid.at(size_t(y) * dim_x + x) == stamp);
+                if (overlaps) {
+                    remaining.push_back(ni);
+                    continue;
+                }
+                for (int y = std::max(bb.y0, 0); y <= std::min(bb.y1, dim_y - 1); y++)
+                    for (int x = std::max(bb.x0, 0); x <= std::min(bb.x1, dim_x - 1); x++)
+                        tail_grid.at(size_t(y) * dim_x + x) = stamp;
+                batch.push_back(ni);
+            }
+            if (int(batch.size()) < min_batch) {
+                for (auto ni : tail)
+                    route_net(st, ni, false);
+                break;
+            }
+            // Seed per net rather than per thread, so the result doesn't depend on which thread picks up a net
+            seeds.clear();
+            for (size_t i = 0; i < batch.size(); i++)
+                seeds.push_back(ctx->rng64());
+            std::atomic<size_t> next_net(0);
+            auto worker = [&](ThreadContext &t) {
+                for (size_t i = next_net++; i < batch.size(); i = next_net++) {
+                    t.rng.rngseed(seeds.at(i));
+                    t.bb = nets.at(batch.at(i)->udata).bb;
+                    if (!route_net(t, batch.at(i), true))
+                        t.failed_nets.push_back(batch.at(i));
+                }
+            };
+            std::vector<std::thread> threads;
+            for (int i = 0; i < std::min(cfg.thread_count, int(batch.size())); i++)
+                threads.emplace_back([&worker, &tcs, i]() { worker(tcs.at(i)); });
+            for (auto &t : threads)
+                t.join();
+            // Retry in net order, again so that the result is independent of thread timing
+            serial.clear();
+            for (auto &t : tcs) {
+                serial.insert(serial.end(), t.failed_nets.begin(), t.failed_nets.end());
+                t.failed_nets.clear();
+            }
+            std::sort(serial.begin(), serial.end(), [](NetInfo *a, NetInfo *b) { return a->udata < b->udata; });
+            for (auto ni : serial)
+                route_net(st, ni, false);
+            std::swap(tail, remaining);
+        }
+    }
+
     void do_route()
     {
         // Don't multithread if fewer than 200 nets (heuristic)
-        if (route_queue.size() < 200) {
+        if (route_queue.size() < 200 || partitions.size() == 1) {
             ThreadContext st;
             st.rng.rngseed(ctx->rng64());
             st.bb = ArcBounds(0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
@@ -1208,88 +1997,145 @@ struct Router2
             }
             return;
         }
-        const int Nq = 4, Nv = 2, Nh = 2;
-        const int N = Nq + Nv + Nh;
-        std::vector<ThreadContext> tcs(N + 1);
-        for (auto &th : tcs) {
-            th.rng.rngseed(ctx->rng64());
-        }
-        int le_x = mid_x;
-        int rs_x = mid_x;
-        int le_y = mid_y;
-        int rs_y = mid_y;
-        // Set up thread bounding boxes
-        tcs.at(0).bb = ArcBounds(0, 0, mid_x, mid_y);
-        tcs.at(1).bb = ArcBounds(mid_x + 1, 0, std::numeric_limits<int>::max(), le_y);
-        tcs.at(2).bb = ArcBounds(0, mid_y + 1, mid_x, std::numeric_limits<int>::max());
-        tcs.at(3).bb =
-                ArcBounds(mid_x + 1, mid_y + 1, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        tcs.at(4).bb = ArcBounds(0, 0, std::numeric_limits<int>::max(), mid_y);
-        tcs.at(5).bb = ArcBounds(0, mid_y + 1, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        tcs.at(6).bb = ArcBounds(0, 0, mid_x, std::numeric_limits<int>::max());
-        tcs.at(7).bb = ArcBounds(mid_x + 1, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        tcs.at(8).bb = ArcBounds(0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        for (auto n : route_queue) {
-            auto &nd = nets.at(n);
-            auto ni = nets_by_udata.at(n);
-            int bin = N;
-            // Quadrants
-            if (nd.bb.x0 < le_x && nd.bb.x1 < le_x && nd.bb.y0 < le_y && nd.bb.y1 < le_y)
-                bin = 0;
-            else if (nd.bb.x0 >= rs_x && nd.bb.x1 >= rs_x && nd.bb.y0 < le_y && nd.bb.y1 < le_y)
-                bin = 1;
-            else if (nd.bb.x0 < le_x && nd.bb.x1 < le_x && nd.bb.y0 >= rs_y && nd.bb.y1 >= rs_y)
-                bin = 2;
-            else if (nd.bb.x0 >= rs_x && nd.bb.x1 >= rs_x && nd.bb.y0 >= rs_y && nd.bb.y1 >= rs_y)
-                bin = 3;
-            // Vertical split
-            else if (nd.bb.y0 < le_y && nd.bb.y1 < le_y)
-                bin = Nq + 0;
-            else if (nd.bb.y0 >= rs_y && nd.bb.y1 >= rs_y)
-                bin = Nq + 1;
-            // Horizontal split
-            else if (nd.bb.x0 < le_x && nd.bb.x1 < le_x)
-                bin = Nq + Nv + 0;
-            else if (nd.bb.x0 >= rs_x && nd.bb.x1 >= rs_x)
-                bin = Nq + Nv + 1;
-            tcs.at(bin).route_nets.push_back(ni);
+        std::vector<ThreadContext> tcs(partitions.size());
+        for (size_t i = 0; i < partitions.size(); i++) {
+            tcs.at(i).rng.rngseed(ctx->rng64());
+            tcs.at(i).bb = partitions.at(i).bb;
         }
+        // A region routes new wires inside its box, but a net's existing routing is also ripped up and checked, so it
+        // goes to the smallest region that holds both
+        for (auto n : route_queue)
+            tcs.at(partition_for(net_route_box(nets.at(n)))).route_nets.push_back(nets_by_udata.at(n));
         if (ctx->verbose)
-            log_info("%d/%d nets not multi-threadable\n", int(tcs.at(N).route_nets.size()), int(route_queue.size()));
-        // Multithreaded part of routing - quadrants
-        std::vector<std::thread> threads;
-        for (int i = 0; i < Nq; i++) {
-            threads.emplace_back([this, &tcs, i]() { router_thread(tcs.at(i)); });
+            log_info("%d/%d nets not multi-threadable\n", int(tcs.at(0).route_nets.size()), int(route_queue.size()));
+        // Multithreaded part of routing. A region only overlaps its own subtree, so it can start as soon as both
+        // its children are done; idle threads take the ready region with the most expected work. Within each
+        // group of equally critical nets in a region, expensive nets go first so that they don't hold up the end
+        // of the iteration; the rest keep the route queue order. The cost of a net is the number of wires it
+        // expanded when last routed, or estimated from its size before that, so that the order is reproducible.
+        const int64_t heavy_net_cost = 10000;
+        auto net_cost = [&](NetInfo *ni) {
+            auto &nd = nets.at(ni->udata);
+            return nd.last_explored >= 0 ? nd.last_explored : net_work(nd);
+        };
+        std::vector<int64_t> region_cost(partitions.size(), 0);
+        for (size_t i = 1; i < tcs.size(); i++) {
+            auto &rn = tcs.at(i).route_nets;
+            std::stable_sort(rn.begin(), rn.end(), [&](NetInfo *a, NetInfo *b) {
+                float crit_a = queue_crit(a->udata), crit_b = queue_crit(b->udata);
+                if (crit_a != crit_b)
+                    return crit_a > crit_b;
+                return net_cost(a) >= heavy_net_cost && net_cost(b) < heavy_net_cost;
+            });
+            for (auto ni : rn)
+                region_cost.at(i) += 1 + net_cost(ni);
         }
-        for (auto &t : threads)
-            t.join();
-        threads.clear();
-        // Vertical splits
-        for (int i = Nq; i < Nq + Nv; i++) {
-            threads.emplace_back([this, &tcs, i]() { router_thread(tcs.at(i)); });
+        std::vector<int> pending(partitions.size(), 0), ready;
+        for (size_t i = 1; i < partitions.size(); i++) {
+            if (partitions.at(i).split == -1)
+                ready.push_back(int(i));
+            else
+                pending.at(i) = 2;
         }
+        int remaining = int(partitions.size()) - 1;
+        std::mutex sched_mutex;
+        std::condition_variable sched_cv;
+        auto worker = [&]() {
+            std::unique_lock<std::mutex> lock(sched_mutex);
+            while (true) {
+                sched_cv.wait(lock, [&]() { return !ready.empty() || remaining == 0; });
+                if (remaining == 0)
+                    return;
+                auto next = std::max_element(ready.begin(), ready.end(),
+                                             [&](int a, int b) { return region_cost.at(a) < region_cost.at(b); });
+                int region = *next;
+                ready.erase(next);
+                lock.unlock();
+                router_thread(tcs.at(region));
+                lock.lock();
+                --remaining;
+                int parent = partitions.at(region).parent;
+                if (parent != 0 && --pending.at(parent) == 0)
+                    ready.push_back(parent);
+                sched_cv.notify_all();
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < std::min(cfg.thread_count, int(partitions.size()) - 1); i++)
+            threads.emplace_back(worker);
         for (auto &t : threads)
             t.join();
-        threads.clear();
-        // Horizontal splits
-        for (int i = Nq + Nv; i < Nq + Nv + Nh; i++) {
-            threads.emplace_back([this, &tcs, i]() { router_thread(tcs.at(i)); });
+        // Nets that cross partitions
+        route_tail(tcs.at(0));
+        // Failed nets
+        for (size_t i = 1; i < tcs.size(); i++)
+            for (auto fail : tcs.at(i).failed_nets)
+                route_net(tcs.at(0), fail, false);
+    }
+
+    // Checks the Arch bindings of a net: every bound wire is driven by a pip bound to the same net (or is the source)
+    // that the Arch still allows, and every sink is connected back to the source. Only reads shared state, so nets
+    // can be checked concurrently.
+    bool check_net_routing(const NetInfo *net)
+    {
+#ifdef ARCH_ECP5
+        if (net->is_global)
+            return true;
+#endif
+        const auto &nd = nets.at(net->udata);
+        if (net->driver.cell == nullptr || nd.src_wire == WireId())
+            return true;
+        for (auto &w : net->wires) {
+            if (ctx->getBoundWireNet(w.first) != net)
+                return false;
+            PipId pip = w.second.pip;
+            if (pip == PipId()) {
+                if (w.first != nd.src_wire)
+                    return false;
+                continue;
+            }
+            if (ctx->getPipDstWire(pip) != w.first || ctx->getBoundPipNet(pip) != net ||
+                !net->wires.count(ctx->getPipSrcWire(pip)))
+                return false;
+#ifdef ARCH_XILINX
+            // Pips can also be ruled out by the placement around them (LUT route-throughs and permutations, site
+            // variants, constant drivers), which the wire bindings don't show
+            if (ctx->usp_pip_hard_unavail(pip))
+                return false;
+#endif
         }
+        for (auto &ad : nd.arcs) {
+            if (ad.sink_wire == WireId())
+                continue;
+            // Bounded walk, so that a loop in the bindings can't hang the check
+            WireId cursor = ad.sink_wire;
+            size_t steps = 0;
+            while (cursor != nd.src_wire) {
+                auto fnd = net->wires.find(cursor);
+                if (fnd == net->wires.end() || fnd->second.pip == PipId() || ++steps > net->wires.size())
+                    return false;
+                cursor = ctx->getPipSrcWire(fnd->second.pip);
+            }
+        }
+        return true;
+    }
+
+    // Returns the number of nets with illegal routing
+    int check_routing()
+    {
+        std::atomic<size_t> next_net(0);
+        std::atomic<int> illegal(0);
+        auto worker = [&]() {
+            for (size_t i = next_net++; i < nets_by_udata.size(); i = next_net++)
+                if (!check_net_routing(nets_by_udata.at(i)))
+                    ++illegal;
+        };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < cfg.thread_count; i++)
+            threads.emplace_back(worker);
         for (auto &t : threads)
             t.join();
-        threads.clear();
-        // Singlethreaded part of routing - nets that cross partitions
-        // or don't fit within bounding box
-        for (auto st_net : tcs.at(N).route_nets)
-            route_net(tcs.at(N), st_net, false);
-        // Failed nets
-        for (int i = 0; i < N; i++)
-            for (auto fail : tcs.at(i).failed_nets)
-                route_net(tcs.at(N), fail, false);
+        return illegal;
     }
 
     //#define ROUTER2_STATISTICS
@@ -1330,41 +2176,46 @@ struct Router2
         auto rstart = std::chrono::high_resolution_clock::now();
         setup_nets();
         setup_wires();
+        if (cfg.eco)
+            adopt_routing();
         find_all_reserved_wires();
+#ifdef ARCH_XILINX
+        route_xilinx_const_nets();
+#endif
+        init_route_bounds();
         partition_nets();
         curr_cong_weight = cfg.init_curr_cong_weight;
+        cong_step = cfg.curr_cong_mult;
         hist_cong_weight = cfg.hist_cong_weight;
         ThreadContext st;
         int iter = 1;
+        int prev_overuse = 0;
 
         for (size_t i = 0; i < nets_by_udata.size(); i++)
-            route_queue.push_back(i);
+            if (!nets.at(i).frozen)
+                route_queue.push_back(i);
 
         timing_driven = ctx->setting<bool>("timing_driven");
         log_info("Running main router loop...\n");
         do {
             ctx->sorted_shuffle(route_queue);
 
+            crit_ordered = false;
             if (timing_driven && (int(route_queue.size()) > (int(nets_by_udata.size()) / 50))) {
                 // Heuristic: reduce runtime by skipping STA in the case of a "long tail" of a few
                 // congested nodes
-                get_criticalities(ctx, &net_crit);
-                for (auto n : route_queue) {
-                    IdString name = nets_by_udata.at(n)->name;
-                    auto fnd = net_crit.find(name);
-                    auto &net = nets.at(n);
-                    net.max_crit = 0;
-                    if (fnd == net_crit.end())
-                        continue;
-                    for (int i = 0; i < int(fnd->second.criticality.size()); i++) {
-                        float c = fnd->second.criticality.at(i);
-                        net.arcs.at(i).arc_crit = c;
-                        net.max_crit = std::max(net.max_crit, c);
-                    }
-                }
-                std::stable_sort(route_queue.begin(), route_queue.end(),
-                                 [&](int na, int nb) { return nets.at(na).max_crit > nets.at(nb).max_crit; });
+                update_criticalities();
+                crit_ordered = true;
             }
+            // Critical nets go first in timing order; within each group of equal criticality, the nets that
+            // contribute most to congestion go first, so that they pick their routes while the contested wires are
+            // still free and the others can avoid them
+            std::stable_sort(route_queue.begin(), route_queue.end(), [&](int na, int nb) {
+                float crit_a = queue_crit(na), crit_b = queue_crit(nb);
+                if (crit_a != crit_b)
+                    return crit_a > crit_b;
+                return nets.at(na).overuse > nets.at(nb).overuse;
+            });
 
 #if 0
             for (size_t j = 0; j < route_queue.size(); j++) {
@@ -1393,8 +2244,17 @@ struct Router2
             log_info("    iter=%d wires=%d overused=%d overuse=%d archfail=%s\n", iter, total_wire_use, overused_wires,
                      total_overuse, overused_wires > 0 ? "NA" : std::to_string(arch_fail).c_str());
             ++iter;
-            if (curr_cong_weight < 1e9)
-                curr_cong_weight += cfg.curr_cong_mult;
+            // Raise the present congestion cost faster while overuse stagnates, and slower while it is falling
+            // quickly, to avoid disturbing routes that are already converging: the step doubles or halves each
+            // iteration, within a bounded range around curr_cong_mult
+            if (curr_cong_weight < 1e9) {
+                if (prev_overuse > 0 && total_overuse > 0.9 * prev_overuse)
+                    cong_step = std::min(cong_step * 2, cfg.curr_cong_mult * 16);
+                else if (prev_overuse > 0 && total_overuse < 0.5 * prev_overuse)
+                    cong_step = std::max(cong_step * 0.5f, cfg.curr_cong_mult * 0.25f);
+                curr_cong_weight += cong_step;
+            }
+            prev_overuse = total_overuse;
         } while (!failed_nets.empty());
         if (cfg.perf_profile) {
             std::vector<std::pair<int, IdString>> nets_by_runtime;
@@ -1412,9 +2272,16 @@ struct Router2
         auto rend = std::chrono::high_resolution_clock::now();
         log_info("Router2 time %.02fs\n", std::chrono::duration<float>(rend - rstart).count());
 
-        log_info("Running router1 to check that route is legal...\n");
-
-        router1(ctx, Router1Cfg(ctx));
+        log_info("Checking that route is legal...\n");
+        int illegal = check_routing();
+        if (illegal > 0) {
+            log_info("    %d nets with illegal routing, running router1 to repair...\n", illegal);
+            router1(ctx, Router1Cfg(ctx));
+        } else {
+            log_info("Checksum: 0x%08x\n", ctx->checksum());
+            timing_analysis(ctx, true /* slack_histogram */, true /* print_fmax */, true /* print_path */,
+                            true /* warn_on_failure */);
+        }
     }
 };
 } // namespace
@@ -1430,6 +2297,7 @@ Router2Cfg::Router2Cfg(Context *ctx)
 {
     backwards_max_iter = ctx->setting<int>("router2/bwdMaxIter", 20);
     global_backwards_max_iter = ctx->setting<int>("router2/glbBwdMaxIter", 200);
+    high_fanout_threshold = ctx->setting<int>("router2/highFanout", 40);
     bb_margin_x = ctx->setting<int>("router2/bbMargin/x", 3);
     bb_margin_y = ctx->setting<int>("router2/bbMargin/y", 3);
     ipin_cost_adder = ctx->setting<float>("router2/ipinCostAdder", 0.0f);
@@ -1437,8 +2305,14 @@ Router2Cfg::Router2Cfg(Context *ctx)
     init_curr_cong_weight = ctx->setting<float>("router2/initCurrCongWeight", 0.5f);
     hist_cong_weight = ctx->setting<float>("router2/histCongWeight", 1.0f);
     curr_cong_mult = ctx->setting<float>("router2/currCongWeightMult", 2.0f);
+    critical_threshold = ctx->setting<float>("router2/criticalThreshold", 0.8f);
     estimate_weight = ctx->setting<float>("router2/estimateWeight", 1.75f);
     perf_profile = ctx->setting<float>("router2/perfProfile", false);
+    thread_count = ctx->setting<int>(
+            "router2/threads",
+            int_or_default(ctx->settings, ctx->id("threads"), std::max(1, int(std::thread::hardware_concurrency()))));
+    partition_depth = ctx->setting<int>("router2/partitionDepth", 5);
+    eco = bool_or_default(ctx->settings, ctx->id("eco"));
 }
 
 NEXTPNR_NAMESPACE_END
@@ -29,6 +29,9 @@ struct Router2Cfg
     int backwards_max_iter;
     // Maximum iterations for backwards routing attempt for global nets
     int global_backwards_max_iter;
+    // Nets with more users than this get a larger backwards routing limit,
+    // and have their arcs routed along a spanning tree of their sinks
+    int high_fanout_threshold;
     // Padding added to bounding boxes to account for imperfect routing,
     // congestion, etc
     int bb_margin_x, bb_margin_y;
@@ -41,12 +44,25 @@ struct Router2Cfg
     float init_curr_cong_weight, hist_cong_weight;
     // Current congestion cost multiplier
     float curr_cong_mult;
+    // Nets with a criticality of at least this are routed first, in timing
+    // order; the rest are ordered by how much congestion they contribute
+    float critical_threshold;
 
     // Weight given to delay estimate in A*. Higher values
     // mean faster and more directed routing, at the risk
     // of choosing a less congestion/delay-optimal route
     float estimate_weight;
 
+    // Maximum number of routing threads, which share out the regions
+    int thread_count;
+    // Levels of recursive bisection of the design into regions that are
+    // routed concurrently; independent of thread_count so that the result
+    // doesn't depend on the machine
+    int partition_depth;
+    // Keep the routing the design was loaded with, and only route arcs that
+    // no longer reach their sink (ECO mode)
+    bool eco;
+
     // Print additional performance profiling information
     bool perf_profile = false;
 };
@@ -19,11 +19,16 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <boost/algorithm/string.hpp>
+#include <boost/crc.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 #include <cmath>
 #include <cstring>
+#include <fstream>
+#include <map>
 #include <queue>
+#include <thread>
 #include "log.h"
 #include "nextpnr.h"
 #include "placer1.h"
@@ -33,6 +38,13 @@
 #include "timing.h"
 #include "util.h"
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
 NEXTPNR_NAMESPACE_BEGIN
 
 static std::pair<std::string, std::string> split_identifier_name(const std::string &name)
@@ -76,6 +88,8 @@ Arch::Arch(ArchArgs args) : args(args)
         log_error("Unable to read chipdb %s\n", args.chipdb.c_str());
     }
 
+    setup_chipdb_sections();
+
     for (int i = 0; i < chip_info->extra_constids->bba_id_count; i++) {
         // log_info("%s %d\n", chip_info->extra_constids->bba_ids[i].get(), int(idstring_idx_to_str->size()));
         IdString::initialize_add(this, chip_info->extra_constids->bba_ids[i].get(),
@@ -87,13 +101,22 @@ Arch::Arch(ArchArgs args) : args(args)
     else
         xc7 = false;
 
+    tile_wire_base.resize(chip_info->num_tiles);
+    int32_t num_wire_slots = chip_info->num_nodes;
+    for (int i = 0; i < chip_info->num_tiles; i++) {
+        tile_wire_base[i] = num_wire_slots;
+        num_wire_slots += chip_info->tile_types[chip_info->tile_insts[i].type].num_wires;
+    }
+    wire_bindings.resize(num_wire_slots);
+
     tileStatus.resize(chip_info->num_tiles);
     for (int i = 0; i < chip_info->num_tiles; i++) {
         tileStatus[i].boundcells.resize(chip_info->tile_types[chip_info->tile_insts[i].type].num_bels);
         tileStatus[i].sitevariant.resize(chip_info->tile_insts[i].num_sites);
     }
 
-    if (xc7)
+    // Newer chipdbs have the blacklist baked in as PIP_ATTR_BLACKLISTED
+    if (xc7 && chip_info->version < 4)
         setup_pip_blacklist();
 }
 
@@ -107,35 +130,203 @@ IdString Arch::archArgsToId(ArchArgs args) const { return IdString(); }
 
 // -----------------------------------------------------------------------
 
-void Arch::setup_byname() const
+void Arch::setup_chipdb_sections()
+{
+    const char *blob = blob_file.data();
+    const char *blob_end = blob + blob_file.size();
+    const char *chip_ptr = reinterpret_cast<const char *>(chip_info);
+    if (chip_ptr < blob || chip_ptr + offsetof(ChipInfoPOD, checksum) > blob_end)
+        log_error("Chipdb %s is corrupt or truncated\n", args.chipdb.c_str());
+    if (chip_info->version > CHIPDB_VERSION)
+        log_error("Chipdb %s has version %d, but this build of nextpnr only supports up to version %d\n",
+                  args.chipdb.c_str(), chip_info->version, CHIPDB_VERSION);
+    // Version 1 chipdbs have no section directory or checksum; they are simply faulted in on demand
+    if (chip_info->version < 2)
+        return;
+    size_t header_size = chip_info->version >= 3 ? sizeof(ChipInfoPOD) : offsetof(ChipInfoPOD, node_encoding);
+    if (chip_ptr + header_size > blob_end)
+        log_error("Chipdb %s is corrupt or truncated\n", args.chipdb.c_str());
+    if (chip_info->version >= 3) {
+        if (chip_info->node_encoding != NODE_WIRES_PLAIN && chip_info->node_encoding != NODE_WIRES_DELTA)
+            log_error("Chipdb %s uses unknown node encoding %d\n", args.chipdb.c_str(), chip_info->node_encoding);
+        delta_nodes = (chip_info->node_encoding == NODE_WIRES_DELTA);
+    }
+
+    if (args.verify_chipdb) {
+        boost::crc_32_type crc;
+        if (chip_info->version >= 5) {
+            // Covers everything, including names and chip_info itself, so that it can key the caches
+            const char *checksum_ptr = chip_ptr + offsetof(ChipInfoPOD, checksum);
+            const char zero[sizeof(uint32_t)] = {};
+            crc.process_block(blob, checksum_ptr);
+            crc.process_block(zero, zero + sizeof(zero));
+            crc.process_block(checksum_ptr + sizeof(uint32_t), blob_end);
+        } else {
+            crc.process_block(blob, chip_ptr);
+        }
+        if (crc.checksum() != chip_info->checksum)
+            log_error("Chipdb %s failed checksum verification (expected %08x, got %08x)\n", args.chipdb.c_str(),
+                      chip_info->checksum, uint32_t(crc.checksum()));
+    }
+
+    for (int i = 0; i < chip_info->num_sections; i++) {
+        const ChipSectionPOD &sec = chip_info->sections[i];
+        const char *begin = sec.begin.get(), *end = sec.end.get();
+        if (begin < blob || end > blob_end || end < begin)
+            log_error("Chipdb %s is corrupt or truncated (section %d out of range)\n", args.chipdb.c_str(), sec.id);
+#ifndef _WIN32
+        if (sec.id >= 0 && sec.id < 32 && (args.prefetch_sections & (1U << sec.id))) {
+            // Start reading in the sections needed for this flow in the background, rather than taking a page fault
+            // for each page on first access
+            uintptr_t page_size = sysconf(_SC_PAGESIZE);
+            uintptr_t page_begin = reinterpret_cast<uintptr_t>(begin) & ~(page_size - 1);
+            madvise(reinterpret_cast<void *>(page_begin), reinterpret_cast<uintptr_t>(end) - page_begin,
+                    MADV_WILLNEED);
+        }
+#endif
+    }
+}
+
+ChipdbCacheKey Arch::chipdbCacheKey() const
 {
-    if (tile_by_name.empty()) {
-        for (int i = 0; i < chip_info->num_tiles; i++) {
-            tile_by_name[chip_info->tile_insts[i].name.get()] = i;
+    if (!chipdb_cache_key_valid) {
+        chipdb_cache_key.chipdb_size = uint64_t(blob_file.size());
+        if (chip_info->version >= 5) {
+            chipdb_cache_key.chipdb_checksum = chip_info->checksum;
+        } else {
+            boost::crc_32_type crc;
+            crc.process_block(blob_file.data(), blob_file.data() + blob_file.size());
+            chipdb_cache_key.chipdb_checksum = crc.checksum();
         }
+        chipdb_cache_key_valid = true;
+    }
+    return chipdb_cache_key;
+}
+
+bool Arch::write_cache_atomically(const std::string &path, const std::vector<std::pair<const void *, size_t>> &parts)
+{
+    std::string tmp_name = path + ".tmp" + std::to_string(getpid());
+    std::ofstream out(tmp_name, std::ios::binary);
+    for (auto &part : parts)
+        out.write(reinterpret_cast<const char *>(part.first), part.second);
+    out.close();
+    if (!out || std::rename(tmp_name.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+static const uint32_t NAME_INDEX_MAGIC = 0x58444e49; // "INDX"
+static const int32_t NAME_INDEX_VERSION = 2;
+
+static std::vector<int32_t> build_name_index(const ChipInfoPOD *chip_info, ChipdbCacheKey key)
+{
+    std::vector<int32_t> tiles;
+    std::vector<std::pair<int32_t, int32_t>> sites;
+    for (int i = 0; i < chip_info->num_tiles; i++) {
+        tiles.push_back(i);
+        for (int j = 0; j < chip_info->tile_insts[i].num_sites; j++)
+            sites.emplace_back(i, j);
+    }
+    std::sort(tiles.begin(), tiles.end(), [&](int32_t a, int32_t b) {
+        return std::strcmp(chip_info->tile_insts[a].name.get(), chip_info->tile_insts[b].name.get()) < 0;
+    });
+    auto site_name = [&](const std::pair<int32_t, int32_t> &s) {
+        return chip_info->tile_insts[s.first].site_insts[s.second].name.get();
+    };
+    std::sort(sites.begin(), sites.end(), [&](const std::pair<int32_t, int32_t> &a,
+                                              const std::pair<int32_t, int32_t> &b) {
+        return std::strcmp(site_name(a), site_name(b)) < 0;
+    });
+
+    std::vector<int32_t> data(sizeof(NameIndexHeaderPOD) / sizeof(int32_t));
+    auto hdr = reinterpret_cast<NameIndexHeaderPOD *>(data.data());
+    hdr->magic = NAME_INDEX_MAGIC;
+    hdr->version = NAME_INDEX_VERSION;
+    hdr->chipdb = key;
+    hdr->num_tiles = int32_t(tiles.size());
+    hdr->num_sites = int32_t(sites.size());
+    data.insert(data.end(), tiles.begin(), tiles.end());
+    for (auto &site : sites) {
+        data.push_back(site.first);
+        data.push_back(site.second);
     }
+    return data;
+}
 
-    if (site_by_name.empty()) {
-        for (int i = 0; i < chip_info->num_tiles; i++) {
-            auto &tile = chip_info->tile_insts[i];
-            for (int j = 0; j < tile.num_sites; j++) {
-                auto name = tile.site_insts[j].name.get();
-                site_by_name[name] = std::make_pair(i, j);
+void Arch::setup_byname() const
+{
+    if (name_index != nullptr)
+        return;
+
+    if (!args.chipdb_cache.empty()) {
+        // Map the sidecar written by an earlier run, if it was built from this exact chipdb
+        try {
+            name_index_file.open(args.chipdb_cache);
+        } catch (...) {
+        }
+        if (name_index_file.is_open()) {
+            auto hdr = reinterpret_cast<const NameIndexHeaderPOD *>(name_index_file.data());
+            if (name_index_file.size() >= sizeof(NameIndexHeaderPOD) && hdr->magic == NAME_INDEX_MAGIC &&
+                hdr->version == NAME_INDEX_VERSION && hdr->chipdb == chipdbCacheKey() &&
+                hdr->num_tiles == chip_info->num_tiles &&
+                name_index_file.size() ==
+                        sizeof(NameIndexHeaderPOD) + sizeof(int32_t) * (hdr->num_tiles + 2 * size_t(hdr->num_sites))) {
+                name_index = hdr;
+                return;
             }
+            name_index_file.close();
         }
     }
+
+    name_index_data = build_name_index(chip_info, args.chipdb_cache.empty() ? ChipdbCacheKey() : chipdbCacheKey());
+    name_index = reinterpret_cast<const NameIndexHeaderPOD *>(name_index_data.data());
+
+    if (!args.chipdb_cache.empty() &&
+        !write_cache_atomically(args.chipdb_cache,
+                                {{name_index_data.data(), name_index_data.size() * sizeof(int32_t)}}))
+        log_warning("Unable to write chipdb cache %s\n", args.chipdb_cache.c_str());
 }
 
-BelId Arch::getBelByName(IdString name) const
+int Arch::find_tile_by_name(const std::string &name) const
 {
-    BelId ret;
+    setup_byname();
+    const int32_t *begin = reinterpret_cast<const int32_t *>(name_index + 1);
+    const int32_t *end = begin + name_index->num_tiles;
+    auto found = std::lower_bound(begin, end, name, [&](int32_t tile, const std::string &n) {
+        return std::strcmp(chip_info->tile_insts[tile].name.get(), n.c_str()) < 0;
+    });
+    if (found == end || name != chip_info->tile_insts[*found].name.get())
+        return -1;
+    return *found;
+}
 
+bool Arch::find_site_by_name(const std::string &name, int &tile, int &site) const
+{
     setup_byname();
+    typedef std::pair<int32_t, int32_t> SiteRef;
+    const SiteRef *begin =
+            reinterpret_cast<const SiteRef *>(reinterpret_cast<const int32_t *>(name_index + 1) + name_index->num_tiles);
+    const SiteRef *end = begin + name_index->num_sites;
+    auto site_name = [&](const SiteRef &s) { return chip_info->tile_insts[s.first].site_insts[s.second].name.get(); };
+    auto found = std::lower_bound(begin, end, name, [&](const SiteRef &s, const std::string &n) {
+        return std::strcmp(site_name(s), n.c_str()) < 0;
+    });
+    if (found == end || name != site_name(*found))
+        return false;
+    tile = found->first;
+    site = found->second;
+    return true;
+}
+
+BelId Arch::getBelByName(IdString name) const
+{
+    BelId ret;
 
     auto split = split_identifier_name(name.str(this));
-    if (site_by_name.count(split.first)) {
-        int tile, site;
-        std::tie(tile, site) = site_by_name.at(split.first);
+    int tile, site;
+    if (find_site_by_name(split.first, tile, site)) {
         auto &tile_info = chip_info->tile_types[chip_info->tile_insts[tile].type];
         IdString belname = id(split.second);
         for (int i = 0; i < tile_info.num_bels; i++) {
@@ -146,7 +337,9 @@ BelId Arch::getBelByName(IdString name) const
             }
         }
     } else {
-        int tile = tile_by_name.at(split.first);
+        tile = find_tile_by_name(split.first);
+        if (tile == -1)
+            return ret;
         auto &tile_info = chip_info->tile_types[chip_info->tile_insts[tile].type];
         IdString belname = id(split.second);
         for (int i = 0; i < tile_info.num_bels; i++) {
@@ -230,13 +423,13 @@ WireId Arch::getWireByName(IdString name) const
     if (wire_by_name_cache.count(name))
         return wire_by_name_cache.at(name);
     WireId ret;
-    setup_byname();
 
     const std::string &s = name.str(this);
     if (s.substr(0, 9) == "SITEWIRE/") {
         auto sp2 = split_identifier_name(s.substr(9));
         int tile, site;
-        std::tie(tile, site) = site_by_name.at(sp2.first);
+        if (!find_site_by_name(sp2.first, tile, site))
+            return ret;
         auto &tile_info = chip_info->tile_types[chip_info->tile_insts[tile].type];
         IdString wirename = id(sp2.second);
         for (int i = 0; i < tile_info.num_wires; i++) {
@@ -248,7 +441,9 @@ WireId Arch::getWireByName(IdString name) const
         }
     } else {
         auto sp = split_identifier_name(s);
-        int tile = tile_by_name.at(sp.first);
+        int tile = find_tile_by_name(sp.first);
+        if (tile == -1)
+            return ret;
         auto &tile_info = chip_info->tile_types[chip_info->tile_insts[tile].type];
         IdString wirename = id(sp.second);
         for (int i = 0; i < tile_info.num_wires; i++) {
@@ -278,13 +473,13 @@ PipId Arch::getPipByName(IdString name) const
     if (pip_by_name_cache.count(name))
         return pip_by_name_cache.at(name);
     PipId ret;
-    setup_byname();
 
     const std::string &s = name.str(this);
     if (s.substr(0, 8) == "SITEPIP/") {
         auto sp2 = split_identifier_name(s.substr(8));
         int tile, site;
-        std::tie(tile, site) = site_by_name.at(sp2.first);
+        if (!find_site_by_name(sp2.first, tile, site))
+            return ret;
         auto &tile_info = chip_info->tile_types[chip_info->tile_insts[tile].type];
         auto sp3 = split_identifier_name(sp2.second);
         IdString belname = id(sp3.first), pinname = id(sp3.second);
@@ -298,7 +493,9 @@ PipId Arch::getPipByName(IdString name) const
         }
     } else {
         auto sp = split_identifier_name(s);
-        int tile = tile_by_name.at(sp.first);
+        int tile = find_tile_by_name(sp.first);
+        if (tile == -1)
+            return ret;
         auto &tile_info = chip_info->tile_types[chip_info->tile_insts[tile].type];
 
         auto spn = split_identifier_name_dot(sp.second);
@@ -339,6 +536,32 @@ IdString Arch::getPipName(PipId pip) const
     }
 }
 
+void Arch::setup_wire_locs() const
+{
+    wire_locs.resize(getWireIndexCount());
+    for (int i = 0; i < chip_info->num_nodes; i++) {
+        int tile = chip_info->nodes[i].tile_wires[0].tile;
+        wire_locs[i].x = tile % chip_info->width;
+        wire_locs[i].y = tile / chip_info->width;
+    }
+    for (int tile = 0; tile < chip_info->num_tiles; tile++) {
+        auto &ti = chip_info->tile_insts[tile];
+        auto &td = chip_info->tile_types[ti.type];
+        for (int j = 0; j < td.num_wires; j++) {
+            WireLoc &loc = wire_locs[tile_wire_base[tile] + j];
+            loc.x = tile % chip_info->width;
+            loc.y = tile / chip_info->width;
+            if (ti.num_sites > 0) {
+                auto &site = ti.site_insts[td.wire_data[j].site != -1 ? td.wire_data[j].site : 0];
+                if (site.inter_x != -1) {
+                    loc.x = site.inter_x;
+                    loc.y = site.inter_y;
+                }
+            }
+        }
+    }
+}
+
 void Arch::setup_pip_blacklist()
 {
     for (int i = 0; i < chip_info->num_tiletypes; i++) {
@@ -446,6 +669,10 @@ std::vector<std::pair<IdString, std::string>> Arch::getBelAttrs(BelId bel) const
 
 // -----------------------------------------------------------------------
 
+// Estimated cost of the last hop into a sink listed in sink_locs. Distances to such sinks are measured to the
+// interconnect tile findSourceSinkLocations found for them, so this models the site entry from there to the pin.
+static const delay_t SINK_ENTRY_DELAY = 1000;
+
 delay_t Arch::estimateDelay(WireId src, WireId dst, bool debug) const
 {
     if (src == dst)
@@ -454,27 +681,26 @@ delay_t Arch::estimateDelay(WireId src, WireId dst, bool debug) const
     int src_intent = wireIntent(src); // , dst_intent = wireIntent(dst);
     // if (src_intent == ID_PSEUDO_GND || dst_intent == ID_PSEUDO_VCC)
     //    return 500;
-    int dst_tile = dst.tile == -1 ? chip_info->nodes[dst.index].tile_wires[0].tile : dst.tile;
-    int src_tile = src.tile == -1 ? chip_info->nodes[src.index].tile_wires[0].tile : src.tile;
-
     if (sink_locs.count(dst)) {
         dst_x = sink_locs.at(dst).x;
         dst_y = sink_locs.at(dst).y;
+        int dst_tile = dst.tile == -1 ? chip_info->nodes[dst.index].tile_wires[0].tile : dst.tile;
+        int src_tile = src.tile == -1 ? chip_info->nodes[src.index].tile_wires[0].tile : src.tile;
         if (src_tile == dst_tile || (sink_locs.count(src) && (sink_locs.at(dst) == sink_locs.at(src)))) {
-            return 1000;
-        }
-    } else if (dst.tile != -1 && chip_info->tile_insts[dst.tile].num_sites > 0) {
-        auto &site = chip_info->tile_insts[dst.tile].site_insts[wireInfo(dst).site != -1 ? wireInfo(dst).site : 0];
-        if (site.inter_x != -1) {
-            dst_x = site.inter_x;
-            dst_y = site.inter_y;
-        } else {
-            dst_x = dst.tile % chip_info->width;
-            dst_y = dst.tile / chip_info->width;
+            return SINK_ENTRY_DELAY;
         }
     } else {
-        dst_x = dst_tile % chip_info->width;
-        dst_y = dst_tile / chip_info->width;
+        dst_x = wireLoc(dst).x;
+        dst_y = wireLoc(dst).y;
+    }
+
+    if (!lookahead_delays.empty() && src_intent < int(lookahead_class.size()) && lookahead_class[src_intent] != -1 &&
+        wireInfo(src).site == -1) {
+        delay_t lookahead = lookaheadDelay(lookahead_class[src_intent], dst_x - wireLoc(src).x, dst_y - wireLoc(src).y);
+        if (debug)
+            log_info("    lookahead %d\n", lookahead);
+        if (lookahead >= 0)
+            return sink_locs.count(dst) ? lookahead + SINK_ENTRY_DELAY : lookahead;
     }
 
     if (src.tile == -1) {
@@ -490,18 +716,20 @@ delay_t Arch::estimateDelay(WireId src, WireId dst, bool debug) const
             if (wireInfo(src).name == gnd_glbl.index || wireInfo(src).name == vcc_glbl.index)
                 return 15000;
 
-            src_x = src_tile % chip_info->width;
-            src_y = src_tile / chip_info->width;
+            src_x = wireLoc(src).x;
+            src_y = wireLoc(src).y;
             if (wireInfo(src).name == gnd_row.index || wireInfo(src).name == vcc_row.index)
                 src_x = chip_info->width / 2;
         } else {
-            auto &src_n = chip_info->nodes[src.index];
             src_x = -1;
             src_y = -1;
-            for (int i = 0; i < std::min(200, src_n.num_tile_wires); i++) {
+            int i = 0;
+            for (WireId src_tw : getTileWireRange(src)) {
+                if (i++ >= 200)
+                    break;
                 // Approximate the nearest location to dest
-                int ti = src_n.tile_wires[i].tile;
-                auto &tw = chip_info->tile_types[chip_info->tile_insts[ti].type].wire_data[src_n.tile_wires[i].index];
+                int ti = src_tw.tile;
+                auto &tw = chip_info->tile_types[chip_info->tile_insts[ti].type].wire_data[src_tw.index];
                 if (tw.num_downhill == 0 && src_intent != ID_NODE_PINFEED)
                     continue;
                 int tix = ti % chip_info->width, tiy = ti / chip_info->width;
@@ -511,23 +739,14 @@ delay_t Arch::estimateDelay(WireId src, WireId dst, bool debug) const
                     src_y = tiy;
             }
             if (src_x == -1) {
-                src_x = chip_info->nodes[src.index].tile_wires[0].tile % chip_info->width;
-                src_y = chip_info->nodes[src.index].tile_wires[0].tile / chip_info->width;
+                src_x = wireLoc(src).x;
+                src_y = wireLoc(src).y;
             }
         }
 
-    } else if (src.tile != -1 && chip_info->tile_insts[src.tile].num_sites > 0) {
-        auto &site = chip_info->tile_insts[src.tile].site_insts[wireInfo(src).site != -1 ? wireInfo(src).site : 0];
-        if (site.inter_x != -1) {
-            src_x = site.inter_x;
-            src_y = site.inter_y;
-        } else {
-            src_x = src.tile % chip_info->width;
-            src_y = src.tile / chip_info->width;
-        }
     } else {
-        src_x = src_tile % chip_info->width;
-        src_y = src_tile / chip_info->width;
+        src_x = wireLoc(src).x;
+        src_y = wireLoc(src).y;
     }
     if (debug)
         log_info("    src (%d, %d) dst (%d, %d)\n", src_x, src_y, dst_x, dst_y);
@@ -549,7 +768,7 @@ delay_t Arch::estimateDelay(WireId src, WireId dst, bool debug) const
         base = (base * 3) / 2;
 
     if (sink_locs.count(dst))
-        base += 1000;
+        base += SINK_ENTRY_DELAY;
     if (src_intent == ID_NODE_PINFEED && dst_x == src_x && dst_y == src_y)
         base -= 200;
     else if ((src_intent == ID_NODE_LOCAL || src_intent == ID_NODE_PINBOUNCE) && dst_x == src_x && dst_y == src_y)
@@ -562,13 +781,11 @@ delay_t Arch::estimateDelay(WireId src, WireId dst, bool debug) const
 
 ArcBounds Arch::getRouteBoundingBox(WireId src, WireId dst) const
 {
-    int dst_tile = dst.tile == -1 ? chip_info->nodes[dst.index].tile_wires[0].tile : dst.tile;
-    int src_tile = src.tile == -1 ? chip_info->nodes[src.index].tile_wires[0].tile : src.tile;
-
+    // Tile wires start from their own tile; the site location (if any) is added below
     int x0, x1, y0, y1;
-    x0 = src_tile % chip_info->width;
+    x0 = src.tile == -1 ? wireLoc(src).x : src.tile % chip_info->width;
     x1 = x0;
-    y0 = src_tile / chip_info->width;
+    y0 = src.tile == -1 ? wireLoc(src).y : src.tile / chip_info->width;
     y1 = y0;
     auto expand = [&](int x, int y) {
         x0 = std::min(x0, x);
@@ -577,26 +794,21 @@ ArcBounds Arch::getRouteBoundingBox(WireId src, WireId dst) const
         y1 = std::max(y1, y);
     };
 
-    expand(dst_tile % chip_info->width, dst_tile / chip_info->width);
+    if (dst.tile == -1)
+        expand(wireLoc(dst).x, wireLoc(dst).y);
+    else
+        expand(dst.tile % chip_info->width, dst.tile / chip_info->width);
 
     if (source_locs.count(src))
         expand(source_locs.at(src).x, source_locs.at(src).y);
 
-    if (sink_locs.count(dst)) {
+    if (sink_locs.count(dst))
         expand(sink_locs.at(dst).x, sink_locs.at(dst).y);
-    } else if (dst.tile != -1 && chip_info->tile_insts[dst.tile].num_sites > 0) {
-        auto &site = chip_info->tile_insts[dst.tile].site_insts[wireInfo(dst).site != -1 ? wireInfo(dst).site : 0];
-        if (site.inter_x != -1) {
-            expand(site.inter_x, site.inter_y);
-        }
-    }
+    else if (dst.tile != -1)
+        expand(wireLoc(dst).x, wireLoc(dst).y);
 
-    if (src.tile != -1 && chip_info->tile_insts[src.tile].num_sites > 0) {
-        auto &site = chip_info->tile_insts[dst.tile].site_insts[wireInfo(dst).site != -1 ? wireInfo(dst).site : 0];
-        if (site.inter_x != -1) {
-            expand(site.inter_x, site.inter_y);
-        }
-    }
+    if (src.tile != -1)
+        expand(wireLoc(src).x, wireLoc(src).y);
     return {x0, y0, x1, y1};
 }
 
@@ -692,7 +904,10 @@ void Arch::routeVcc()
     log_info("Routing Vcc connections...\n");
     // Special pass for faster routing of Vcc psuedo-net
     NetInfo *vcc = nets[id("$PACKER_VCC_NET")].get();
-    bindWire(getCtx()->getNetinfoSourceWire(vcc), vcc, STRENGTH_STRONG);
+    WireId vcc_src = getCtx()->getNetinfoSourceWire(vcc);
+    // In ECO mode the source, like the sinks that are still routed, may be bound already
+    if (getBoundWireNet(vcc_src) != vcc)
+        bindWire(vcc_src, vcc, STRENGTH_STRONG);
 #if 0
     WireId wire0 = getCtx()->getNetinfoSourceWire(vcc);
     Loc drvloc = getBelLocation(vcc->driver.cell->bel);
@@ -744,139 +959,169 @@ void Arch::routeVcc()
     }
 }
 
-void Arch::routeClock()
+bool Arch::isGlobalClockNet(const NetInfo *clk_net, bool &to_pll_mmcm_clkin1) const
 {
-    log_info("Routing global clocks...\n");
-    // Special pass for faster routing of global clock psuedo-net
-    for (auto net : sorted(nets)) {
-        NetInfo *clk_net = net.second;
-        auto clk_driver = clk_net->driver;
-        if (clk_driver.cell == nullptr)
-            continue;
-        auto driver_type = clk_driver.cell->type;
-        auto no_users = clk_net->users.size();
-        auto clk_net_user = no_users == 1 ? clk_net->users.front().cell : nullptr;
-        auto clk_net_user_type = clk_net_user == nullptr ? IdString() : clk_net_user->type;
-        auto from_pll_or_mmcm =
-            driver_type == id_PLLE2_ADV_PLLE2_ADV ||
-            driver_type == id_MMCME2_ADV_MMCME2_ADV;
-        auto to_pll_or_mmcm =
-            clk_net_user_type == id_PLLE2_ADV_PLLE2_ADV ||
-            clk_net_user_type == id_MMCME2_ADV_MMCME2_ADV;
-        auto to_pll_mmcm_clkin1 = to_pll_or_mmcm && clk_net->users.front().port == id_CLKIN1;
-
-        // check if we have a global clock net, skip otherwise
-        bool is_global = false;
-        if ((driver_type == id_BUFGCTRL    || driver_type == id_BUFCE_BUFG_PS ||
-             driver_type == id_BUFCE_BUFCE || driver_type == id_BUFGCE_DIV_BUFGCE_DIV) &&
-            clk_driver.port == id_O)
-            is_global = true;
-        else if (no_users == 1 && from_pll_or_mmcm &&
-                 (clk_net_user_type == id_BUFGCTRL || clk_net_user_type == id_BUFCE_BUFCE ||
-                  clk_net_user_type == id_BUFGCE_DIV_BUFGCE_DIV))
-            is_global = true;
-        else if (to_pll_mmcm_clkin1)
-            is_global = true;
-        if (!is_global)
-            continue;
-
-        log_info("    routing clock '%s'\n", clk_net->name.c_str(this));
-        bindWire(getCtx()->getNetinfoSourceWire(clk_net), clk_net, STRENGTH_LOCKED);
+    auto clk_driver = clk_net->driver;
+    to_pll_mmcm_clkin1 = false;
+    if (clk_driver.cell == nullptr)
+        return false;
+    auto driver_type = clk_driver.cell->type;
+    auto no_users = clk_net->users.size();
+    auto clk_net_user = no_users == 1 ? clk_net->users.front().cell : nullptr;
+    auto clk_net_user_type = clk_net_user == nullptr ? IdString() : clk_net_user->type;
+    auto from_pll_or_mmcm =
+        driver_type == id_PLLE2_ADV_PLLE2_ADV ||
+        driver_type == id_MMCME2_ADV_MMCME2_ADV;
+    auto to_pll_or_mmcm =
+        clk_net_user_type == id_PLLE2_ADV_PLLE2_ADV ||
+        clk_net_user_type == id_MMCME2_ADV_MMCME2_ADV;
+    to_pll_mmcm_clkin1 = to_pll_or_mmcm && clk_net->users.front().port == id_CLKIN1;
+
+    if ((driver_type == id_BUFGCTRL    || driver_type == id_BUFCE_BUFG_PS ||
+         driver_type == id_BUFCE_BUFCE || driver_type == id_BUFGCE_DIV_BUFGCE_DIV) &&
+        clk_driver.port == id_O)
+        return true;
+    if (no_users == 1 && from_pll_or_mmcm &&
+        (clk_net_user_type == id_BUFGCTRL || clk_net_user_type == id_BUFCE_BUFCE ||
+         clk_net_user_type == id_BUFGCE_DIV_BUFGCE_DIV))
+        return true;
+    return to_pll_mmcm_clkin1;
+}
 
-        for (auto &usr : clk_net->users) {
-            std::queue<WireId> visit;
-            std::unordered_map<WireId, PipId> backtrace;
-            WireId dest = WireId();
-
-            auto sink_wire = getCtx()->getNetinfoSinkWire(clk_net, usr);
-            if (getCtx()->debug) {
-                auto sink_wire_name = "(uninitialized)";
-                if (sink_wire != WireId())
-                    sink_wire_name = nameOfWire(sink_wire);
-                log_info("        routing arc to %s.%s (wire %s):\n", usr.cell->name.c_str(this), usr.port.c_str(this), sink_wire_name);
-            }
+namespace {
+// General routing that global clocks must not use
+bool is_general_routing_intent(int intent)
+{
+    return intent == ID_NODE_DOUBLE || intent == ID_NODE_HLONG || intent == ID_NODE_HQUAD || intent == ID_NODE_VLONG ||
+           intent == ID_NODE_VQUAD || intent == ID_NODE_SINGLE || intent == ID_NODE_CLE_OUTPUT ||
+           intent == ID_NODE_OPTDELAY || intent == ID_BENTQUAD || intent == ID_DOUBLE || intent == ID_HLONG ||
+           intent == ID_HQUAD || intent == ID_OPTDELAY || intent == ID_SINGLE || intent == ID_VLONG ||
+           intent == ID_VLONG12 || intent == ID_VQUAD || intent == ID_PINBOUNCE;
+}
+} // namespace
 
+int Arch::findClockRoute(const NetInfo *clk_net, bool to_pll_mmcm_clkin1, ClockRoute &route) const
+{
+    // Wires of the route so far, that further users can branch off. Nothing is bound while searching, so that
+    // clock nets can be searched concurrently.
+    pool<WireId> tree;
+    dict<WireId, PipId> backtrace;
+    std::queue<WireId> visit;
+    int failures = 0;
+
+    route.clear();
+    WireId src_wire = getCtx()->getNetinfoSourceWire(clk_net);
+    route.emplace_back(src_wire, PipId());
+    tree.insert(src_wire);
+
+    for (auto &usr : clk_net->users) {
+        auto sink_wire = getCtx()->getNetinfoSinkWire(clk_net, usr);
+        if (sink_wire == WireId())
+            continue;
+        WireId dest = WireId();
+        // Dedicated clock resources first; due to some missing pips, a PLL/MMCM CLKIN1 may fall back to any routing
+        for (bool lenient : {false, true}) {
+            if (lenient && !to_pll_mmcm_clkin1)
+                break;
+            std::queue<WireId> empty;
+            std::swap(visit, empty);
+            backtrace.clear();
             visit.push(sink_wire);
             while (!visit.empty()) {
                 WireId curr = visit.front();
                 visit.pop();
-                if (getBoundWireNet(curr) == clk_net) {
+                if (tree.count(curr)) {
                     dest = curr;
                     break;
                 }
                 for (auto uh : getPipsUphill(curr)) {
-                    if (!checkPipAvail(uh)) {
-                        if (getCtx()->debug) log_info("            skipping unavailable pip %s\n", getPipName(uh).c_str(this));
+                    if (!checkPipAvail(uh))
                         continue;
-                    }
                     WireId src = getPipSrcWire(uh);
-                    auto srcname = getWireName(src).str(this);
-                    if (backtrace.count(src)) {
+                    if (backtrace.count(src))
+                        continue;
+                    if (!lenient && is_general_routing_intent(wireIntent(src)))
+                        continue;
+                    if (!checkWireAvail(src) && getBoundWireNet(src) != clk_net)
                         continue;
-                    }
-                    int intent = wireIntent(src);
-                    if (intent == ID_NODE_DOUBLE || intent == ID_NODE_HLONG || intent == ID_NODE_HQUAD ||
-                        intent == ID_NODE_VLONG || intent == ID_NODE_VQUAD || intent == ID_NODE_SINGLE ||
-                        intent == ID_NODE_CLE_OUTPUT || intent == ID_NODE_OPTDELAY || intent == ID_BENTQUAD ||
-                        intent == ID_DOUBLE || intent == ID_HLONG || intent == ID_HQUAD || intent == ID_OPTDELAY ||
-                        intent == ID_SINGLE || intent == ID_VLONG || intent == ID_VLONG12 || intent == ID_VQUAD ||
-                        intent == ID_PINBOUNCE)
-                        {
-                            continue;
-                        }
-                    auto avail     = checkWireAvail(src);
-                    auto bound_net = getBoundWireNet(src);
-                    if (!avail && bound_net != clk_net)
-                        {
-                            if (getCtx()->debug)
-                                log_info("            skipping unavailable wire %s used by net %s\n", srcname.c_str(), bound_net->name.c_str(this));
-                            continue;
-                        }
                     backtrace[src] = uh;
                     visit.push(src);
                 }
             }
-            if (dest == WireId()) {
-                log_info("            failed to find a route using dedicated resources.\n");
-                if (to_pll_mmcm_clkin1) {
-                    // Due to some missing pips, currently special case more lenient solution
-                    std::queue<WireId> empty;
-                    std::swap(visit, empty);
-                    backtrace.clear();
-                    visit.push(sink_wire);
-                    while (!visit.empty()) {
-                        WireId curr = visit.front();
-                        visit.pop();
-                        if (getBoundWireNet(curr) == clk_net) {
-                            dest = curr;
-                            break;
-                        }
-                        for (auto uh : getPipsUphill(curr)) {
-                            if (!checkPipAvail(uh))
-                                continue;
-                            WireId src = getPipSrcWire(uh);
-                            if (backtrace.count(src))
-                                continue;
-                            if (!checkWireAvail(src) && getBoundWireNet(src) != clk_net)
-                                continue;
-                            backtrace[src] = uh;
-                            visit.push(src);
-                        }
-                    }
-                    if (dest == WireId())
-                        continue;
-                } else {
-                    continue;
-                }
-            }
-            while (backtrace.count(dest)) {
-                auto uh = backtrace[dest];
-                dest = getPipDstWire(uh);
-                if (getCtx()->debug)
-                    log_info("            bind pip %s\n", nameOfPip(uh));
-                bindWire(dest, clk_net, STRENGTH_LOCKED);
-                bindPip(uh, clk_net, STRENGTH_LOCKED);
-            }
+            if (dest != WireId())
+                break;
+            if (!lenient)
+                ++failures;
+        }
+        if (dest == WireId())
+            continue;
+        while (backtrace.count(dest)) {
+            auto uh = backtrace.at(dest);
+            dest = getPipDstWire(uh);
+            route.emplace_back(dest, uh);
+            tree.insert(dest);
+        }
+    }
+    return failures;
+}
+
+void Arch::routeClock()
+{
+    log_info("Routing global clocks...\n");
+    // Special pass for faster routing of global clock psuedo-net
+    struct ClockNet
+    {
+        NetInfo *net;
+        bool to_pll_mmcm_clkin1;
+        ClockRoute route;
+        int failures;
+    };
+    std::vector<ClockNet> clocks;
+    bool eco = bool_or_default(settings, id("eco"));
+    for (auto net : sorted(nets)) {
+        bool to_pll_mmcm_clkin1;
+        if (!isGlobalClockNet(net.second, to_pll_mmcm_clkin1))
+            continue;
+        // In ECO mode, Arch::route has already unbound the clocks whose routing is incomplete
+        if (eco && !net.second->wires.empty())
+            continue;
+        clocks.push_back(ClockNet{net.second, to_pll_mmcm_clkin1, {}, 0});
+    }
+
+    // Clock nets rarely compete for the same resources, so search them all in parallel against the current
+    // bindings; then bind in name order, re-routing any net whose route has since been taken by an earlier one
+    std::atomic<size_t> next_clock(0);
+    auto worker = [&]() {
+        for (size_t i = next_clock++; i < clocks.size(); i = next_clock++)
+            clocks.at(i).failures = findClockRoute(clocks.at(i).net, clocks.at(i).to_pll_mmcm_clkin1,
+                                                   clocks.at(i).route);
+    };
+    std::vector<std::thread> threads;
+    int num_threads = int_or_default(settings, id("threads"), int(std::thread::hardware_concurrency()));
+    num_threads = std::min(num_threads, int(clocks.size()));
+    for (int i = 0; i < std::max(num_threads, 1); i++)
+        threads.emplace_back(worker);
+    for (auto &t : threads)
+        t.join();
+
+    for (auto &clk : clocks) {
+        log_info("    routing clock '%s'\n", clk.net->name.c_str(this));
+        bool conflict = false;
+        for (auto &step : clk.route)
+            if (!checkWireAvail(step.first) || (step.second != PipId() && !checkPipAvail(step.second)))
+                conflict = true;
+        if (conflict)
+            clk.failures = findClockRoute(clk.net, clk.to_pll_mmcm_clkin1, clk.route);
+        if (clk.failures > 0)
+            log_info("        %d arcs failed to find a route using dedicated resources.\n", clk.failures);
+        bindWire(clk.route.front().first, clk.net, STRENGTH_LOCKED);
+        for (auto &step : clk.route) {
+            if (step.second == PipId())
+                continue;
+            if (getCtx()->debug)
+                log_info("            bind pip %s\n", nameOfPip(step.second));
+            bindWire(step.first, clk.net, STRENGTH_LOCKED);
+            bindPip(step.second, clk.net, STRENGTH_LOCKED);
         }
     }
 #if 0
@@ -915,10 +1160,157 @@ void Arch::routeClock()
 #endif
 }
 
+Arch::PinLocSearch Arch::searchPinLoc(WireId root, bool is_source) const
+{
+    // Search backwards from sinks (forwards from sources) for the nearest general routing wire
+    PinLocSearch result;
+    std::queue<WireId> visit;
+    std::unordered_map<WireId, WireId> backtrace;
+    int iter = 0;
+    // as this is a best-effort optimisation to slightly improve routing,
+    // don't spend too long with a nice low iteration limit
+    const int iter_max = 500;
+    visit.push(root);
+    while (!visit.empty() && iter < iter_max) {
+        ++iter;
+        WireId cursor = visit.front();
+        visit.pop();
+        if (wireInfo(cursor).site == -1) {
+            int intent = wireIntent(cursor);
+            bool general = intent != ID_NODE_PINFEED && intent != ID_PSEUDO_VCC && intent != ID_PSEUDO_GND &&
+                           intent != ID_INTENT_DEFAULT && intent != ID_NODE_DEDICATED && intent != ID_NODE_OPTDELAY;
+            if (is_source)
+                general = general && intent != ID_NODE_OUTPUT && intent != ID_NODE_INT_INTERFACE;
+            else
+                general = general && intent != ID_PINFEED && intent != ID_INPUT;
+            if (general) {
+                result.tile = cursor.tile == -1 ? chip_info->nodes[cursor.index].tile_wires[0].tile : cursor.tile;
+                if (getCtx()->debug) {
+                    if (is_source)
+                        log_info("%s ----> %s\n", nameOfWire(root), nameOfWire(cursor));
+                    else
+                        log_info("%s <---- %s\n", nameOfWire(root), nameOfWire(cursor));
+                }
+                while (backtrace.count(cursor)) {
+                    cursor = backtrace.at(cursor);
+                    result.path.push_back(cursor);
+                }
+                break;
+            }
+        }
+        if (is_source) {
+            for (auto pip : getPipsDownhill(cursor)) {
+                WireId dst = getPipDstWire(pip);
+                if (!backtrace.count(dst)) {
+                    backtrace[dst] = cursor;
+                    visit.push(dst);
+                }
+            }
+        } else {
+            for (auto pip : getPipsUphill(cursor)) {
+                WireId src = getPipSrcWire(pip);
+                if (!backtrace.count(src)) {
+                    backtrace[src] = cursor;
+                    visit.push(src);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+static const uint32_t PIN_LOCS_MAGIC = 0x434f4c50; // "PLOC"
+static const int32_t PIN_LOCS_VERSION = 2;
+
+void Arch::loadPinLocCache(std::map<std::pair<bool, WireId>, PinLocSearch> &searches) const
+{
+    std::ifstream in(args.pin_locs_cache, std::ios::binary);
+    if (!in)
+        return;
+    std::vector<int32_t> data;
+    int32_t word;
+    while (in.read(reinterpret_cast<char *>(&word), sizeof(word)))
+        data.push_back(word);
+    ChipdbCacheKey key = chipdbCacheKey();
+    // The chipdb size is stored as two words, low word first
+    if (data.size() < 6 || uint32_t(data[0]) != PIN_LOCS_MAGIC || data[1] != PIN_LOCS_VERSION ||
+        uint32_t(data[2]) != uint32_t(key.chipdb_size) || uint32_t(data[3]) != uint32_t(key.chipdb_size >> 32) ||
+        uint32_t(data[4]) != key.chipdb_checksum)
+        return;
+    size_t cursor = 6;
+    auto read_wire = [&]() {
+        WireId wire;
+        wire.tile = data.at(cursor++);
+        wire.index = data.at(cursor++);
+        return wire;
+    };
+    try {
+        for (int32_t i = 0; i < data[5]; i++) {
+            bool is_source = data.at(cursor++) != 0;
+            WireId root = read_wire();
+            PinLocSearch &search = searches[std::make_pair(is_source, root)];
+            search.tile = data.at(cursor++);
+            int32_t path_len = data.at(cursor++);
+            for (int32_t j = 0; j < path_len; j++)
+                search.path.push_back(read_wire());
+        }
+    } catch (std::out_of_range &) {
+        log_warning("Pin location cache %s is truncated, ignoring it\n", args.pin_locs_cache.c_str());
+        searches.clear();
+    }
+}
+
+void Arch::savePinLocCache(const std::map<std::pair<bool, WireId>, PinLocSearch> &searches) const
+{
+    ChipdbCacheKey key = chipdbCacheKey();
+    std::vector<int32_t> data{int32_t(PIN_LOCS_MAGIC),
+                              PIN_LOCS_VERSION,
+                              int32_t(uint32_t(key.chipdb_size)),
+                              int32_t(uint32_t(key.chipdb_size >> 32)),
+                              int32_t(key.chipdb_checksum),
+                              int32_t(searches.size())};
+    for (auto &entry : searches) {
+        data.push_back(entry.first.first ? 1 : 0);
+        data.push_back(entry.first.second.tile);
+        data.push_back(entry.first.second.index);
+        data.push_back(entry.second.tile);
+        data.push_back(int32_t(entry.second.path.size()));
+        for (WireId wire : entry.second.path) {
+            data.push_back(wire.tile);
+            data.push_back(wire.index);
+        }
+    }
+    if (!write_cache_atomically(args.pin_locs_cache, {{data.data(), data.size() * sizeof(int32_t)}}))
+        log_warning("Unable to write pin location cache %s\n", args.pin_locs_cache.c_str());
+}
+
 void Arch::findSourceSinkLocations()
 {
-    // Use a backwards BFS to find the real location of sinks, on a best-effort basis
-#if 1
+    // Use a BFS to find the real location of sinks and sources, on a best-effort basis. Searches only depend on the
+    // chipdb, so they can be reused from earlier runs through args.pin_locs_cache.
+    std::map<std::pair<bool, WireId>, PinLocSearch> searches;
+    if (!args.pin_locs_cache.empty())
+        loadPinLocCache(searches);
+    bool searches_changed = false;
+
+    auto apply_search = [&](WireId root, bool is_source) {
+        auto key = std::make_pair(is_source, root);
+        auto found = searches.find(key);
+        if (found == searches.end()) {
+            found = searches.emplace(key, searchPinLoc(root, is_source)).first;
+            searches_changed = true;
+        }
+        const PinLocSearch &search = found->second;
+        if (search.tile == -1)
+            return;
+        auto &locs = is_source ? source_locs : sink_locs;
+        Loc loc(search.tile % chip_info->width, search.tile / chip_info->width, 0);
+        locs[root] = loc;
+        for (WireId wire : search.path)
+            if (!locs.count(wire))
+                locs[wire] = loc;
+    };
+
     for (auto net : sorted(nets)) {
         NetInfo *ni = net.second;
         for (auto &usr : ni->users) {
@@ -928,46 +1320,7 @@ void Arch::findSourceSinkLocations()
             WireId sink = getCtx()->getNetinfoSinkWire(ni, usr);
             if (sink == WireId() || sink_locs.count(sink))
                 continue;
-            std::queue<WireId> visit;
-            std::unordered_map<WireId, WireId> backtrace;
-            int iter = 0;
-            // as this is a best-effort optimisation to slightly improve routing,
-            // don't spend too long with a nice low iteration limit
-            const int iter_max = 500;
-            visit.push(sink);
-            while (!visit.empty() && iter < iter_max) {
-                ++iter;
-                WireId cursor = visit.front();
-                visit.pop();
-                if (wireInfo(cursor).site == -1) {
-                    int intent = wireIntent(cursor);
-                    if (intent != ID_NODE_PINFEED && intent != ID_PSEUDO_VCC && intent != ID_PSEUDO_GND &&
-                        intent != ID_INTENT_DEFAULT && intent != ID_NODE_DEDICATED && intent != ID_NODE_OPTDELAY &&
-                        intent != ID_PINFEED && intent != ID_INPUT) {
-                        int tile = cursor.tile == -1 ? chip_info->nodes[cursor.index].tile_wires[0].tile : cursor.tile;
-                        sink_locs[sink] = Loc(tile % chip_info->width, tile / chip_info->width, 0);
-                        if (getCtx()->debug) {
-                            log_info("%s <---- %s\n", nameOfWire(sink), nameOfWire(cursor));
-                        }
-
-                        while (backtrace.count(cursor)) {
-                            cursor = backtrace.at(cursor);
-                            if (!sink_locs.count(cursor)) {
-                                sink_locs[cursor] = Loc(tile % chip_info->width, tile / chip_info->width, 0);
-                            }
-                        }
-
-                        break;
-                    }
-                }
-                for (auto pip : getPipsUphill(cursor)) {
-                    WireId src = getPipSrcWire(pip);
-                    if (!backtrace.count(src)) {
-                        backtrace[src] = cursor;
-                        visit.push(getPipSrcWire(pip));
-                    }
-                }
-            }
+            apply_search(sink, false);
         }
 
         auto &drv = ni->driver;
@@ -978,55 +1331,38 @@ void Arch::findSourceSinkLocations()
             WireId source = getCtx()->getNetinfoSourceWire(ni);
             if (source == WireId() || source_locs.count(source))
                 continue;
-            std::queue<WireId> visit;
-            std::unordered_map<WireId, WireId> backtrace;
-            int iter = 0;
-            // as this is a best-effort optimisation to slightly improve routing,
-            // don't spend too long with a nice low iteration limit
-            const int iter_max = 500;
-            visit.push(source);
-            while (!visit.empty() && iter < iter_max) {
-                ++iter;
-                WireId cursor = visit.front();
-                visit.pop();
-                if (wireInfo(cursor).site == -1) {
-                    int intent = wireIntent(cursor);
-                    if (intent != ID_NODE_PINFEED && intent != ID_PSEUDO_VCC && intent != ID_PSEUDO_GND &&
-                        intent != ID_INTENT_DEFAULT && intent != ID_NODE_DEDICATED && intent != ID_NODE_OPTDELAY &&
-                        intent != ID_NODE_OUTPUT && intent != ID_NODE_INT_INTERFACE) {
-                        int tile = cursor.tile == -1 ? chip_info->nodes[cursor.index].tile_wires[0].tile : cursor.tile;
-                        source_locs[source] = Loc(tile % chip_info->width, tile / chip_info->width, 0);
-                        if (getCtx()->debug) {
-                            log_info("%s ----> %s\n", nameOfWire(source), nameOfWire(cursor));
-                        }
-
-                        while (backtrace.count(cursor)) {
-                            cursor = backtrace.at(cursor);
-                            if (!source_locs.count(cursor)) {
-                                source_locs[cursor] = Loc(tile % chip_info->width, tile / chip_info->width, 0);
-                            }
-                        }
-
-                        break;
-                    }
-                }
-                for (auto pip : getPipsDownhill(cursor)) {
-                    WireId dst = getPipDstWire(pip);
-                    if (!backtrace.count(dst)) {
-                        backtrace[dst] = cursor;
-                        visit.push(getPipDstWire(pip));
-                    }
-                }
-            }
+            apply_search(source, true);
         }
     }
-#endif
+
+    if (!args.pin_locs_cache.empty() && searches_changed)
+        savePinLocCache(searches);
 }
 
 bool Arch::route()
 {
     assign_budget(getCtx(), true);
     std::string router = str_or_default(settings, id("router"), defaultRouter);
+    // Built before any routing is bound (bar that of a design loaded in ECO mode), as bound wires affect pip delays
+    if (args.router_lookahead && lookahead_delays.empty())
+        setup_lookahead();
+    if (bool_or_default(settings, id("eco"))) {
+        // Keep the routing the design was loaded with, less any branches left dangling by changed cells. Clocks
+        // are only ever routed whole, so an incomplete one is ripped up for routeClock to route again.
+        restoreLutPermutationRouting();
+        auto unrouted = getCtx()->pruneRouting();
+        log_info("ECO mode: %d nets need routing\n", int(unrouted.size()));
+        for (auto net : unrouted) {
+            bool to_pll_mmcm_clkin1;
+            if (!isGlobalClockNet(net, to_pll_mmcm_clkin1))
+                continue;
+            std::vector<WireId> clock_wires;
+            for (auto &w : net->wires)
+                clock_wires.push_back(w.first);
+            for (auto w : clock_wires)
+                unbindWire(w);
+        }
+    }
     if (router != "router2")
         routeVcc();
     routeClock();
@@ -26,6 +26,7 @@
 #include <boost/iostreams/device/mapped_file.hpp>
 
 #include <iostream>
+#include <mutex>
 
 NEXTPNR_NAMESPACE_BEGIN
 
@@ -160,10 +161,16 @@ enum PipType
     PIP_CONST_DRIVER = 6,
 };
 
+enum PipAttrs : int16_t
+{
+    // Pip must never be used by the router (only set from chipdb version 4 onwards)
+    PIP_ATTR_BLACKLISTED = 0x0001,
+};
+
 NPNR_PACKED_STRUCT(struct PipInfoPOD {
     int32_t src_index, dst_index;
     int32_t timing_class;
-    int16_t padding;
+    int16_t attrs; // bitmask of PipAttrs
     int16_t flags;
 
     int32_t bel;          // name of bel containing pip
@@ -193,6 +200,15 @@ NPNR_PACKED_STRUCT(struct TileWireRefPOD {
     int32_t index;
 });
 
+enum NodeWireEncoding : int32_t
+{
+    // NodeInfoPOD::tile_wires is a plain array of TileWireRefPOD
+    NODE_WIRES_PLAIN = 0,
+    // The first TileWireRefPOD is stored as-is, followed by a byte stream of zigzag varint
+    // (tile delta, wire index delta) pairs relative to the previous entry for the remaining wires
+    NODE_WIRES_DELTA = 1,
+};
+
 NPNR_PACKED_STRUCT(struct NodeInfoPOD {
     int32_t num_tile_wires;
     int32_t intent;
@@ -310,6 +326,24 @@ NPNR_PACKED_STRUCT(struct TimingDataPOD {
     RelPtr<PipTimingPOD> pip_timing_classes;
 });
 
+// Highest chipdb version understood by this build
+static const int32_t CHIPDB_VERSION = 5;
+
+enum ChipSectionId : int32_t
+{
+    SECTION_CONSTIDS = 0,
+    SECTION_TILE_TYPES = 1,
+    SECTION_TILE_INSTS = 2,
+    SECTION_NODES = 3,
+    SECTION_TIMING = 4,
+};
+
+NPNR_PACKED_STRUCT(struct ChipSectionPOD {
+    int32_t id;
+    RelPtr<char> begin;
+    RelPtr<char> end;
+});
+
 NPNR_PACKED_STRUCT(struct ChipInfoPOD {
     RelPtr<char> name;
     RelPtr<char> generator;
@@ -325,6 +359,15 @@ NPNR_PACKED_STRUCT(struct ChipInfoPOD {
 
     int32_t num_speed_grades;
     RelPtr<TimingDataPOD> timing_data;
+
+    // Only present from version 2 onwards
+    // CRC-32 of the blob up to the start of this struct; from version 5, of the whole blob with this field as zero
+    uint32_t checksum;
+    int32_t num_sections;
+    RelPtr<ChipSectionPOD> sections;
+
+    // Only present from version 3 onwards
+    int32_t node_encoding; // see NodeWireEncoding
 });
 
 /************************ End of chipdb section. ************************/
@@ -380,6 +423,18 @@ struct BelRange
 
 // -----------------------------------------------------------------------
 
+inline int32_t read_zigzag_varint(const uint8_t *&ptr)
+{
+    uint32_t z = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t b = *ptr++;
+        z |= uint32_t(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            break;
+    }
+    return int32_t(z >> 1) ^ -int32_t(z & 1);
+}
+
 // Iterate over TileWires for a wire (will be more than one if nodal)
 struct TileWireIterator
 {
@@ -387,13 +442,36 @@ struct TileWireIterator
     WireId baseWire;
     int cursor = -1;
 
-    void operator++() { cursor++; }
+    // Decoder state for NODE_WIRES_DELTA node lists, which can only be walked sequentially
+    bool delta = false;
+    const uint8_t *stream = nullptr;
+    WireId curr;
+
+    void operator++()
+    {
+        cursor++;
+        if (delta && baseWire.tile == -1) {
+            const NodeInfoPOD &node = chip->nodes[baseWire.index];
+            if (cursor >= node.num_tile_wires)
+                return;
+            if (cursor == 0) {
+                curr.tile = node.tile_wires[0].tile;
+                curr.index = node.tile_wires[0].index;
+                stream = reinterpret_cast<const uint8_t *>(node.tile_wires.get() + 1);
+            } else {
+                curr.tile += read_zigzag_varint(stream);
+                curr.index += read_zigzag_varint(stream);
+            }
+        }
+    }
     bool operator!=(const TileWireIterator &other) const { return cursor != other.cursor; }
 
     // Returns a *denormalised* identifier always pointing to a tile wire rather than a node
     WireId operator*() const
     {
         if (baseWire.tile == -1) {
+            if (delta)
+                return curr;
             WireId tw;
             const auto &node_wire = chip->nodes[baseWire.index].tile_wires[cursor];
             tw.tile = node_wire.tile;
@@ -671,21 +749,76 @@ struct BelPinRange
 struct ArchArgs
 {
     std::string chipdb;
+    // Bitmask of ChipSectionId to ask the OS to prefetch after mapping the chipdb
+    uint32_t prefetch_sections = ~0U;
+    // Verify the chipdb checksum at startup (this reads the whole file)
+    bool verify_chipdb = false;
+    // Sidecar file holding name lookup tables derived from the chipdb, shared between runs (optional)
+    std::string chipdb_cache;
+    // Use a lookahead table built from the routing graph for router delay estimates
+    bool router_lookahead = false;
+    // File to load the lookahead table from, or to save it to if missing or stale (optional)
+    std::string router_lookahead_cache;
+    // File caching the searches of findSourceSinkLocations between runs (optional)
+    std::string pin_locs_cache;
 };
 
+// Identifies the chipdb an on-disk cache was built from, see Arch::chipdbCacheKey()
+NPNR_PACKED_STRUCT(struct ChipdbCacheKey {
+    uint64_t chipdb_size;
+    uint32_t chipdb_checksum;
+
+    bool operator==(const ChipdbCacheKey &other) const
+    {
+        return chipdb_size == other.chipdb_size && chipdb_checksum == other.chipdb_checksum;
+    }
+});
+
+// Header of the name lookup sidecar. It is followed by num_tiles tile indices sorted by tile name, then by num_sites
+// (tile, site) pairs sorted by site name. Names themselves are not stored; they are compared against the chipdb.
+NPNR_PACKED_STRUCT(struct NameIndexHeaderPOD {
+    uint32_t magic;
+    int32_t version;
+    ChipdbCacheKey chipdb;
+    int32_t num_tiles;
+    int32_t num_sites;
+});
+
 struct Arch : BaseCtx
 {
     boost::iostreams::mapped_file_source blob_file;
     const ChipInfoPOD *chip_info;
 
-    mutable std::unordered_map<std::string, int> tile_by_name;
-    mutable std::unordered_map<std::string, std::pair<int, int>> site_by_name;
-
-    dict<WireId, NetInfo *> wire_to_net;
-    dict<PipId, NetInfo *> pip_to_net;
-    dict<WireId, std::pair<int, int>> driving_pip_loc;
+    // Name lookup tables, either mapped from the args.chipdb_cache sidecar or built in memory by setup_byname()
+    mutable boost::iostreams::mapped_file_source name_index_file;
+    mutable std::vector<int32_t> name_index_data;
+    mutable const NameIndexHeaderPOD *name_index = nullptr;
+
+    // Key shared by the name index, lookahead and pin location caches. Chipdbs from version 5 checksum the whole blob;
+    // for older ones it is computed here on first use, as their checksum (if any) doesn't cover names or chip_info.
+    ChipdbCacheKey chipdbCacheKey() const;
+    mutable ChipdbCacheKey chipdb_cache_key;
+    mutable bool chipdb_cache_key_valid = false;
+    // Write a cache file from the given parts via a temporary file and rename, so that concurrent runs never read a
+    // partial one. Returns false on failure.
+    static bool write_cache_atomically(const std::string &path,
+                                       const std::vector<std::pair<const void *, size_t>> &parts);
+
+    // Binding state of a canonical wire
+    struct WireBinding
+    {
+        NetInfo *net = nullptr;
+        // Pip driving the wire if it was bound by bindPip, which is also how pip bindings are stored
+        PipId pip;
+    };
+    // Indexed by getWireIndex()
+    std::vector<WireBinding> wire_bindings;
+    std::vector<int32_t> tile_wire_base;
     dict<WireId, NetInfo *> reserved_wires;
 
+    WireBinding &wireBinding(WireId wire) { return wire_bindings[getWireIndex(wire)]; }
+    const WireBinding &wireBinding(WireId wire) const { return wire_bindings[getWireIndex(wire)]; }
+
     struct LogicTileStatus
     {
         // z -> cell
@@ -743,7 +876,15 @@ struct Arch : BaseCtx
 
     // -------------------------------------------------
 
+    // Whether node tile wire lists are NODE_WIRES_DELTA encoded
+    bool delta_nodes = false;
+
+    void setup_chipdb_sections();
     void setup_byname() const;
+    // Return the tile index with a given name, or -1 if there is none
+    int find_tile_by_name(const std::string &name) const;
+    // Look up a site by name, returning false if there is none
+    bool find_site_by_name(const std::string &name, int &tile, int &site) const;
 
     BelId getBelByName(IdString name) const;
 
@@ -991,11 +1132,55 @@ struct Arch : BaseCtx
 
     uint32_t getWireChecksum(WireId wire) const { return wire.index; }
 
+    // Dense, stable index of a canonical wire for use with flat per-wire arrays. Node wires come first, indexed by
+    // node, followed by every tile wire indexed by tile_wire_base[tile] + index. Tile wires that are part of a node
+    // never appear as canonical wires, so their indices are unused.
+    int getWireIndex(WireId wire) const
+    {
+        return wire.tile == -1 ? wire.index : tile_wire_base[wire.tile] + wire.index;
+    }
+
+    // Inverse of getWireIndex; returns WireId() for unused indices
+    WireId getWireByIndex(int index) const
+    {
+        WireId wire;
+        if (index < chip_info->num_nodes) {
+            wire.index = index;
+            return wire;
+        }
+        auto next_tile = std::upper_bound(tile_wire_base.begin(), tile_wire_base.end(), index);
+        int tile = int(next_tile - tile_wire_base.begin()) - 1;
+        wire = canonicalWireId(chip_info, tile, index - tile_wire_base[tile]);
+        return wire.tile == tile ? wire : WireId();
+    }
+
+    // Upper bound (exclusive) on the values returned by getWireIndex
+    int getWireIndexCount() const { return int(wire_bindings.size()); }
+
+    // Notional location of a wire, used for delay estimates and routing bounding boxes: the first tile of a node,
+    // or for tile wires the interconnect location of their site if there is one, else the tile itself
+    struct WireLoc
+    {
+        int16_t x, y;
+    };
+    // Indexed by getWireIndex(), built on first use
+    mutable std::vector<WireLoc> wire_locs;
+    mutable std::once_flag wire_locs_once;
+    void setup_wire_locs() const;
+
+    const WireLoc &wireLoc(WireId wire) const
+    {
+        std::call_once(wire_locs_once, [this]() { setup_wire_locs(); });
+        return wire_locs[getWireIndex(wire)];
+    }
+
     void bindWire(WireId wire, NetInfo *net, PlaceStrength strength)
     {
         NPNR_ASSERT(wire != WireId());
-        NPNR_ASSERT(wire_to_net[wire] == nullptr);
-        wire_to_net[wire] = net;
+        auto &binding = wireBinding(wire);
+        NPNR_ASSERT(binding.net == nullptr);
+        binding.net = net;
+        binding.pip = PipId();
         net->wires[wire].pip = PipId();
         net->wires[wire].strength = strength;
         refreshUiWire(wire);
@@ -1004,27 +1189,23 @@ struct Arch : BaseCtx
     void unbindWire(WireId wire)
     {
         NPNR_ASSERT(wire != WireId());
-        NPNR_ASSERT(wire_to_net[wire] != nullptr);
+        auto &binding = wireBinding(wire);
+        NPNR_ASSERT(binding.net != nullptr);
 
-        auto &net_wires = wire_to_net[wire]->wires;
+        auto &net_wires = binding.net->wires;
         auto it = net_wires.find(wire);
         NPNR_ASSERT(it != net_wires.end());
 
-        auto pip = it->second.pip;
-        if (pip != PipId()) {
-            pip_to_net[pip] = nullptr;
-        }
-
         net_wires.erase(it);
-        wire_to_net[wire] = nullptr;
+        binding.net = nullptr;
+        binding.pip = PipId();
         refreshUiWire(wire);
     }
 
     bool checkWireAvail(WireId wire) const
     {
         NPNR_ASSERT(wire != WireId());
-        auto w2n = wire_to_net.find(wire);
-        return w2n == wire_to_net.end() || w2n->second == nullptr;
+        return wireBinding(wire).net == nullptr;
     }
 
     NetInfo *getReservedWireNet(WireId wire) const
@@ -1037,8 +1218,7 @@ struct Arch : BaseCtx
     NetInfo *getBoundWireNet(WireId wire) const
     {
         NPNR_ASSERT(wire != WireId());
-        auto w2n = wire_to_net.find(wire);
-        return w2n == wire_to_net.end() ? nullptr : w2n->second;
+        return wireBinding(wire).net;
     }
 
     WireId getConflictingWireWire(WireId wire) const { return wire; }
@@ -1046,8 +1226,7 @@ struct Arch : BaseCtx
     NetInfo *getConflictingWireNet(WireId wire) const
     {
         NPNR_ASSERT(wire != WireId());
-        auto w2n = wire_to_net.find(wire);
-        return w2n == wire_to_net.end() ? nullptr : w2n->second;
+        return wireBinding(wire).net;
     }
 
     DelayInfo getWireDelay(WireId wire) const
@@ -1063,6 +1242,7 @@ struct Arch : BaseCtx
         range.b.chip = chip_info;
         range.b.baseWire = wire;
         range.b.cursor = -1;
+        range.b.delta = delta_nodes;
         ++range.b;
 
         range.e.chip = chip_info;
@@ -1112,15 +1292,14 @@ struct Arch : BaseCtx
     void bindPip(PipId pip, NetInfo *net, PlaceStrength strength)
     {
         NPNR_ASSERT(pip != PipId());
-        NPNR_ASSERT(pip_to_net[pip] == nullptr);
 
         WireId dst = canonicalWireId(chip_info, pip.tile, locInfo(pip).pip_data[pip.index].dst_index);
-        NPNR_ASSERT(wire_to_net[dst] == nullptr || wire_to_net[dst] == net);
+        auto &binding = wireBinding(dst);
+        NPNR_ASSERT(binding.pip != pip);
+        NPNR_ASSERT(binding.net == nullptr || binding.net == net);
 
-        pip_to_net[pip] = net;
-        driving_pip_loc[dst] = std::make_pair(pip.tile % chip_info->width, pip.tile / chip_info->width);
-
-        wire_to_net[dst] = net;
+        binding.net = net;
+        binding.pip = pip;
         net->wires[dst].pip = pip;
         net->wires[dst].strength = strength;
         refreshUiPip(pip);
@@ -1130,24 +1309,28 @@ struct Arch : BaseCtx
     void unbindPip(PipId pip)
     {
         NPNR_ASSERT(pip != PipId());
-        NPNR_ASSERT(pip_to_net[pip] != nullptr);
 
         WireId dst = canonicalWireId(chip_info, pip.tile, locInfo(pip).pip_data[pip.index].dst_index);
-        NPNR_ASSERT(wire_to_net[dst] != nullptr);
-        wire_to_net[dst] = nullptr;
-        pip_to_net[pip]->wires.erase(dst);
+        auto &binding = wireBinding(dst);
+        NPNR_ASSERT(binding.pip == pip && binding.net != nullptr);
+        binding.net->wires.erase(dst);
 
-        pip_to_net[pip] = nullptr;
+        binding.net = nullptr;
+        binding.pip = PipId();
         refreshUiPip(pip);
         refreshUiWire(dst);
     }
 
+    // Only used for chipdbs older than version 4, which lack PIP_ATTR_BLACKLISTED
     dict<int, pool<int>> blacklist_pips;
     void setup_pip_blacklist();
 
     bool usp_pip_hard_unavail(PipId pip) const
     {
-        if (blacklist_pips.count(locInfo(pip).type) && blacklist_pips.at(locInfo(pip).type).count(pip.index))
+        if (locInfo(pip).pip_data[pip.index].attrs & PIP_ATTR_BLACKLISTED)
+            return true;
+        if (!blacklist_pips.empty() && blacklist_pips.count(locInfo(pip).type) &&
+            blacklist_pips.at(locInfo(pip).type).count(pip.index))
             return true;
         if (locInfo(pip).pip_data[pip.index].flags == PIP_SITE_ENTRY) {
             WireId dst = getPipDstWire(pip);
@@ -1216,14 +1399,14 @@ struct Arch : BaseCtx
         NPNR_ASSERT(pip != PipId());
         if (usp_pip_hard_unavail(pip))
             return false;
-        return pip_to_net.find(pip) == pip_to_net.end() || pip_to_net.at(pip) == nullptr;
+        return getBoundPipNet(pip) == nullptr;
     }
 
     NetInfo *getBoundPipNet(PipId pip) const
     {
         NPNR_ASSERT(pip != PipId());
-        auto p2n = pip_to_net.find(pip);
-        return p2n == pip_to_net.end() ? nullptr : p2n->second;
+        auto &binding = wireBinding(getPipDstWire(pip));
+        return binding.pip == pip ? binding.net : nullptr;
     }
 
     WireId getConflictingPipWire(PipId pip) const
@@ -1237,9 +1420,7 @@ struct Arch : BaseCtx
     {
         if (usp_pip_hard_unavail(pip))
             return nullptr;
-        NPNR_ASSERT(pip != PipId());
-        auto p2n = pip_to_net.find(pip);
-        return p2n == pip_to_net.end() ? nullptr : p2n->second;
+        return getBoundPipNet(pip);
     }
 
     AllPipRange getPips() const
@@ -1395,11 +1576,11 @@ struct Arch : BaseCtx
                 auto &pip_data = locInfo(pip).pip_data[pip.index];
                 auto &pip_timing = chip_info->timing_data->pip_timing_classes[pip_data.timing_class];
                 int src_len = 1;
-                auto found_srcloc = driving_pip_loc.find(getPipSrcWire(pip));
-                if (found_srcloc != driving_pip_loc.end()) {
-                    src_len =
-                            std::max(1, std::abs(found_srcloc->second.first - (pip.tile % chip_info->width)) +
-                                                std::abs(found_srcloc->second.second - (pip.tile / chip_info->width)));
+                PipId src_driver = wireBinding(getPipSrcWire(pip)).pip;
+                if (src_driver != PipId()) {
+                    int dx = (src_driver.tile % chip_info->width) - (pip.tile % chip_info->width);
+                    int dy = (src_driver.tile / chip_info->width) - (pip.tile / chip_info->width);
+                    src_len = std::max(1, std::abs(dx) + std::abs(dy));
                 }
                 auto &src_timing =
                         chip_info->timing_data
@@ -1480,6 +1661,30 @@ struct Arch : BaseCtx
 
     // -------------------------------------------------
     mutable IdString gnd_glbl, gnd_row, vcc_glbl, vcc_row;
+
+    // Router lookahead (see lookahead.cc). lookahead_class maps a wire intent to a class, and lookahead_delays holds
+    // one (2 * LOOKAHEAD_RADIUS + 1)^2 row per class of minimum delays to each (dx, dy) offset, -1 if unreached
+    static const int LOOKAHEAD_RADIUS = 12;
+    std::vector<int32_t> lookahead_class;
+    std::vector<delay_t> lookahead_delays;
+    void setup_lookahead();
+    void build_lookahead();
+
+    // Returns -1 if the lookahead has no entry for this class and offset
+    delay_t lookaheadDelay(int cls, int dx, int dy) const
+    {
+        const int span = 2 * LOOKAHEAD_RADIUS + 1;
+        int cdx = std::max(-LOOKAHEAD_RADIUS, std::min(LOOKAHEAD_RADIUS, dx));
+        int cdy = std::max(-LOOKAHEAD_RADIUS, std::min(LOOKAHEAD_RADIUS, dy));
+        size_t row = size_t(cls) * span + (cdy + LOOKAHEAD_RADIUS);
+        delay_t base = lookahead_delays[row * span + (cdx + LOOKAHEAD_RADIUS)];
+        if (base < 0)
+            return -1;
+        // Beyond the table, extend using the long-distance slopes of the fallback estimate
+        delay_t excess = 10 * (std::abs(dx) - std::abs(cdx)) + 20 * (std::abs(dy) - std::abs(cdy));
+        return base + (xc7 ? (excess * 3) / 2 : excess);
+    }
+
     delay_t estimateDelay(WireId src, WireId dst, bool debug = false) const;
     delay_t predictDelay(const NetInfo *net_info, const PortRef &sink) const;
     ArcBounds getRouteBoundingBox(WireId src, WireId dst) const;
@@ -1620,9 +1825,29 @@ struct Arch : BaseCtx
 
     void fixupPlacement();
     void fixupRouting();
+    // For a design loaded with its routing, move LUT input routes off the permutation pips fixupRouting folded
+    // into the netlist
+    void restoreLutPermutationRouting();
 
     void routeVcc();
+
+    // A global clock route: the wires to bind, each with its driving pip (none for the source)
+    typedef std::vector<std::pair<WireId, PipId>> ClockRoute;
+    bool isGlobalClockNet(const NetInfo *clk_net, bool &to_pll_mmcm_clkin1) const;
+    // Returns the number of users that could not be reached through dedicated clock resources
+    int findClockRoute(const NetInfo *clk_net, bool to_pll_mmcm_clkin1, ClockRoute &route) const;
     void routeClock();
+
+    // Outcome of the search from a non-logic pin wire to the nearest general routing wire: the tile of that wire (-1
+    // if none was found within the iteration limit), and the wires on the path between the two
+    struct PinLocSearch
+    {
+        int32_t tile = -1;
+        std::vector<WireId> path;
+    };
+    PinLocSearch searchPinLoc(WireId root, bool is_source) const;
+    void loadPinLocCache(std::map<std::pair<bool, WireId>, PinLocSearch> &searches) const;
+    void savePinLocCache(const std::map<std::pair<bool, WireId>, PinLocSearch> &searches) const;
     void findSourceSinkLocations();
     std::unordered_map<WireId, Loc> sink_locs, source_locs;
     // -------------------------------------------------
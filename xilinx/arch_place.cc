@@ -917,6 +917,47 @@ void Arch::fixupPlacement()
     }
 }
 
+void Arch::restoreLutPermutationRouting()
+{
+    /*
+     * fixupRouting connects each permuted net to the LUT port it physically enters on, but leaves the permutation pip
+     * bound; so in a reloaded design that pip leads to the wrong LUT input. Unbind such pips, and reach the input the
+     * net is now connected to through its identity permutation pip from the same pin wire instead.
+     */
+    std::vector<WireId> permuted;
+    for (auto net : sorted(nets)) {
+        for (auto &wire : net.second->wires) {
+            PipId pip = wire.second.pip;
+            if (pip == PipId())
+                continue;
+            auto &pd = locInfo(pip).pip_data[pip.index];
+            if (pd.flags == PIP_LUT_PERMUTATION && ((pd.extra_data >> 4) & 0xF) != (pd.extra_data & 0xF))
+                permuted.push_back(wire.first);
+        }
+    }
+    for (auto wire : permuted)
+        unbindWire(wire);
+
+    for (auto net : sorted(nets)) {
+        NetInfo *ni = net.second;
+        for (auto &usr : ni->users) {
+            WireId sink = getCtx()->getNetinfoSinkWire(ni, usr);
+            if (sink == WireId() || !checkWireAvail(sink))
+                continue;
+            for (auto pip : getPipsUphill(sink)) {
+                auto &pd = locInfo(pip).pip_data[pip.index];
+                if (pd.flags != PIP_LUT_PERMUTATION || ((pd.extra_data >> 4) & 0xF) != (pd.extra_data & 0xF))
+                    continue;
+                auto src = ni->wires.find(getPipSrcWire(pip));
+                if (src == ni->wires.end())
+                    continue;
+                bindPip(pip, ni, src->second.strength);
+                break;
+            }
+        }
+    }
+}
+
 void Arch::fixupRouting()
 {
     log_info("Running post-routing legalisation...\n");
@@ -0,0 +1,228 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <thread>
+#include "log.h"
+#include "nextpnr.h"
+#include "util.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// The router lookahead is a table of the minimum delay from a routing wire of a given intent to any wire at a
+// given (dx, dy) tile offset from it. It is built by Dijkstra sweeps from a few sample wires of each intent and
+// optionally cached on disk, keyed by the chipdb it was built from.
+
+namespace {
+
+const uint32_t LOOKAHEAD_MAGIC = 0x44484b4c; // "LKHD"
+const int32_t LOOKAHEAD_VERSION = 2;
+
+// Sample sources per intent, and the number of wires each sweep may expand
+const int LOOKAHEAD_SAMPLES = 3;
+const int LOOKAHEAD_MAX_VISIT = 100000;
+
+NPNR_PACKED_STRUCT(struct LookaheadHeaderPOD {
+    uint32_t magic;
+    int32_t version;
+    ChipdbCacheKey chipdb;
+    int32_t radius;
+    int32_t num_intents;
+    int32_t num_classes;
+    // followed by num_intents int32 class indices, then the delay table
+});
+
+struct QueuedWire
+{
+    delay_t delay;
+    WireId wire;
+    bool operator>(const QueuedWire &other) const
+    {
+        return delay > other.delay || (delay == other.delay && other.wire < wire);
+    }
+};
+
+bool lookahead_pip_allowed(const Arch *arch, PipId pip)
+{
+    auto &pd = arch->locInfo(pip).pip_data[pip.index];
+    if (pd.attrs & PIP_ATTR_BLACKLISTED)
+        return false;
+    return pd.flags == PIP_TILE_ROUTING || pd.flags == PIP_SITE_ENTRY || pd.flags == PIP_SITE_EXIT;
+}
+
+// Run a bounded Dijkstra sweep from src, lowering the entries of row (one class of the lookahead table)
+void lookahead_sweep(const Arch *arch, WireId src, std::vector<delay_t> &row)
+{
+    const int radius = Arch::LOOKAHEAD_RADIUS, span = 2 * radius + 1;
+    // Allow paths to leave the table window slightly, as the fastest route may double back
+    const int margin = 3;
+    auto src_loc = arch->wireLoc(src);
+
+    dict<WireId, delay_t> best;
+    std::priority_queue<QueuedWire, std::vector<QueuedWire>, std::greater<QueuedWire>> queue;
+    best[src] = 0;
+    queue.push(QueuedWire{0, src});
+
+    int visited = 0;
+    while (!queue.empty() && visited < LOOKAHEAD_MAX_VISIT) {
+        QueuedWire curr = queue.top();
+        queue.pop();
+        if (best.at(curr.wire) < curr.delay)
+            continue;
+        ++visited;
+
+        auto loc = arch->wireLoc(curr.wire);
+        int dx = loc.x - src_loc.x, dy = loc.y - src_loc.y;
+        if (std::abs(dx) <= radius && std::abs(dy) <= radius) {
+            delay_t &entry = row.at((dy + radius) * span + (dx + radius));
+            entry = std::min(entry, curr.delay);
+        }
+        if (std::abs(dx) > radius + margin || std::abs(dy) > radius + margin)
+            continue;
+
+        for (PipId pip : arch->getPipsDownhill(curr.wire)) {
+            if (!lookahead_pip_allowed(arch, pip))
+                continue;
+            WireId dst = arch->getPipDstWire(pip);
+            delay_t next = curr.delay + arch->getPipDelay(pip).maxDelay() + arch->getWireDelay(dst).maxDelay();
+            auto found = best.find(dst);
+            if (found != best.end() && found->second <= next)
+                continue;
+            best[dst] = next;
+            queue.push(QueuedWire{next, dst});
+        }
+    }
+}
+
+} // namespace
+
+void Arch::build_lookahead()
+{
+    const int span = 2 * LOOKAHEAD_RADIUS + 1;
+
+    // Group routing wires by intent, keeping the wire nearest to each sample point as a sweep source. Sample points
+    // are spread across the device so that edge effects average out.
+    std::vector<Loc> sample_points;
+    for (int i = 0; i < LOOKAHEAD_SAMPLES; i++)
+        sample_points.emplace_back(chip_info->width * (i + 1) / (LOOKAHEAD_SAMPLES + 1),
+                                   chip_info->height * (i + 1) / (LOOKAHEAD_SAMPLES + 1), 0);
+    std::vector<std::vector<WireId>> class_sources;
+    std::vector<std::vector<int>> class_source_dist;
+    lookahead_class.clear();
+    for (WireId wire : getWires()) {
+        int intent = wireIntent(wire);
+        auto &wi = wireInfo(wire);
+        if (wi.site != -1 || wi.num_downhill == 0 || intent == ID_PSEUDO_GND || intent == ID_PSEUDO_VCC)
+            continue;
+        if (intent >= int(lookahead_class.size()))
+            lookahead_class.resize(intent + 1, -1);
+        if (lookahead_class[intent] == -1) {
+            lookahead_class[intent] = int32_t(class_sources.size());
+            class_sources.emplace_back(LOOKAHEAD_SAMPLES);
+            class_source_dist.emplace_back(LOOKAHEAD_SAMPLES, std::numeric_limits<int>::max());
+        }
+        int cls = lookahead_class[intent];
+        auto loc = wireLoc(wire);
+        for (int i = 0; i < LOOKAHEAD_SAMPLES; i++) {
+            int dist = std::abs(loc.x - sample_points[i].x) + std::abs(loc.y - sample_points[i].y);
+            if (dist < class_source_dist[cls][i]) {
+                class_source_dist[cls][i] = dist;
+                class_sources[cls][i] = wire;
+            }
+        }
+    }
+
+    int num_classes = int(class_sources.size());
+    std::vector<delay_t> table(size_t(num_classes) * span * span, std::numeric_limits<delay_t>::max());
+
+    // Each class is independent, so threads pull whole classes and the result does not depend on the thread count
+    std::atomic<int> next_class(0);
+    auto worker = [&]() {
+        std::vector<delay_t> row(span * span);
+        for (int cls = next_class++; cls < num_classes; cls = next_class++) {
+            std::fill(row.begin(), row.end(), std::numeric_limits<delay_t>::max());
+            for (WireId src : class_sources[cls])
+                lookahead_sweep(this, src, row);
+            std::copy(row.begin(), row.end(), table.begin() + size_t(cls) * span * span);
+        }
+    };
+    int num_threads = int_or_default(settings, id("threads"), int(std::thread::hardware_concurrency()));
+    num_threads = std::max(1, std::min(num_threads, num_classes));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++)
+        threads.emplace_back(worker);
+    for (auto &t : threads)
+        t.join();
+
+    for (auto &entry : table)
+        if (entry == std::numeric_limits<delay_t>::max())
+            entry = -1;
+    lookahead_delays = std::move(table);
+}
+
+void Arch::setup_lookahead()
+{
+    const int span = 2 * LOOKAHEAD_RADIUS + 1;
+    const std::string &cache = args.router_lookahead_cache;
+
+    if (!cache.empty()) {
+        std::ifstream in(cache, std::ios::binary);
+        LookaheadHeaderPOD hdr;
+        if (in && in.read(reinterpret_cast<char *>(&hdr), sizeof(hdr)) && hdr.magic == LOOKAHEAD_MAGIC &&
+            hdr.version == LOOKAHEAD_VERSION && hdr.chipdb == chipdbCacheKey() && hdr.radius == LOOKAHEAD_RADIUS &&
+            hdr.num_intents >= 0 && hdr.num_classes >= 0) {
+            lookahead_class.resize(hdr.num_intents);
+            lookahead_delays.resize(size_t(hdr.num_classes) * span * span);
+            in.read(reinterpret_cast<char *>(lookahead_class.data()), lookahead_class.size() * sizeof(int32_t));
+            in.read(reinterpret_cast<char *>(lookahead_delays.data()), lookahead_delays.size() * sizeof(delay_t));
+            // estimateDelay indexes the table by class unchecked, so reject anything out of range or left over
+            bool valid = in && in.peek() == std::char_traits<char>::eof() &&
+                         std::all_of(lookahead_class.begin(), lookahead_class.end(),
+                                     [&](int32_t cls) { return cls >= -1 && cls < hdr.num_classes; });
+            if (valid) {
+                log_info("Loaded router lookahead from %s\n", cache.c_str());
+                return;
+            }
+            log_warning("Router lookahead cache %s is corrupt, rebuilding it\n", cache.c_str());
+            lookahead_class.clear();
+            lookahead_delays.clear();
+        }
+    }
+
+    log_info("Building router lookahead...\n");
+    build_lookahead();
+
+    if (!cache.empty()) {
+        LookaheadHeaderPOD hdr;
+        hdr.magic = LOOKAHEAD_MAGIC;
+        hdr.version = LOOKAHEAD_VERSION;
+        hdr.chipdb = chipdbCacheKey();
+        hdr.radius = LOOKAHEAD_RADIUS;
+        hdr.num_intents = int32_t(lookahead_class.size());
+        hdr.num_classes = int32_t(lookahead_delays.size() / (span * span));
+        if (!write_cache_atomically(cache, {{&hdr, sizeof(hdr)},
+                                            {lookahead_class.data(), lookahead_class.size() * sizeof(int32_t)},
+                                            {lookahead_delays.data(), lookahead_delays.size() * sizeof(delay_t)}}))
+            log_warning("Unable to write router lookahead cache %s\n", cache.c_str());
+    }
+}
+
+NEXTPNR_NAMESPACE_END
@@ -48,6 +48,16 @@ po::options_description UspCommandHandler::getArchOptions()
 {
     po::options_description specific("Architecture specific options");
     specific.add_options()("chipdb", po::value<std::string>(), "name of chip database binary");
+    specific.add_options()("chipdb-verify", "verify the chip database checksum on startup");
+    specific.add_options()("chipdb-cache", po::value<std::string>(),
+                           "sidecar file for name lookup tables derived from the chip database, shared between runs "
+                           "(created if missing or stale)");
+    specific.add_options()("router-lookahead", "use a delay table built from the routing graph for router estimates");
+    specific.add_options()("router-lookahead-cache", po::value<std::string>(),
+                           "file to load the router lookahead from, built and saved if missing or stale "
+                           "(implies --router-lookahead)");
+    specific.add_options()("pin-locs-cache", po::value<std::string>(),
+                           "file caching the routing locations of IO and hard block pins between runs");
     specific.add_options()("xdc", po::value<std::vector<std::string>>(), "XDC-style constraints file");
     specific.add_options()("fasm", po::value<std::string>(), "fasm bitstream file to write");
 
@@ -69,6 +79,19 @@ std::unique_ptr<Context> UspCommandHandler::createContext(std::unordered_map<std
         log_error("chip database binary must be provided\n");
     }
     chipArgs.chipdb = vm["chipdb"].as<std::string>();
+    chipArgs.verify_chipdb = vm.count("chipdb-verify") != 0;
+    if (vm.count("chipdb-cache"))
+        chipArgs.chipdb_cache = vm["chipdb-cache"].as<std::string>();
+    if (vm.count("router-lookahead-cache"))
+        chipArgs.router_lookahead_cache = vm["router-lookahead-cache"].as<std::string>();
+    if (vm.count("pin-locs-cache"))
+        chipArgs.pin_locs_cache = vm["pin-locs-cache"].as<std::string>();
+    chipArgs.router_lookahead = vm.count("router-lookahead") || !chipArgs.router_lookahead_cache.empty();
+    // Only prefetch the parts of the chipdb that this flow is going to touch
+    if (vm.count("pack-only"))
+        chipArgs.prefetch_sections &= ~((1U << SECTION_NODES) | (1U << SECTION_TIMING));
+    else if (vm.count("no-place") && vm.count("no-route"))
+        chipArgs.prefetch_sections &= ~(1U << SECTION_NODES);
     return std::unique_ptr<Context>(new Context(chipArgs));
 }
 
@@ -28,7 +28,8 @@ std::string XC7Packer::get_gtp_site(const std::string &io_bel)
     auto pad_site = io_bel.substr(0, io_bel.find('/'));
 
     int tileid, siteid;
-    std::tie(tileid, siteid) = ctx->site_by_name.at(pad_site);
+    if (!ctx->find_site_by_name(pad_site, tileid, siteid))
+        log_error("Unknown site '%s'\n", pad_site.c_str());
     auto tile = &ctx->chip_info->tile_insts[tileid];
     for (int s = 0; s < tile->num_sites; s++) {
         auto site = &tile->site_insts[s];
@@ -46,7 +47,8 @@ void XC7Packer::constrain_ibufds_gtp_site(CellInfo *buf_cell, const std::string
     auto pad_site = io_bel.substr(0, io_bel.find('/'));
 
     int tileid, siteid;
-    std::tie(tileid, siteid) = ctx->site_by_name.at(pad_site);
+    if (!ctx->find_site_by_name(pad_site, tileid, siteid))
+        log_error("Unknown site '%s'\n", pad_site.c_str());
     auto tile = &ctx->chip_info->tile_insts[tileid];
 
     int32_t min_buf_y = 0x7FFFFFFF;
@@ -56,11 +56,9 @@ CellInfo *XC7Packer::insert_diffibuf(IdString name, IdString type, const std::ar
 
 std::string XC7Packer::get_tilename_by_sitename(Context *ctx, std::string site)
 {
-    if (ctx->site_by_name.count(site)) {
-        int tile, siteid;
-        std::tie(tile, siteid) = ctx->site_by_name.at(site);
+    int tile, siteid;
+    if (ctx->find_site_by_name(site, tile, siteid))
         return ctx->chip_info->tile_insts[tile].name.get();
-    }
     return std::string();
 }
 
@@ -275,11 +273,6 @@ void XC7Packer::decompose_iob(CellInfo *xil_iob, bool is_hr, const std::string &
 
 void XC7Packer::pack_io()
 {
-    // make sure the supporting data structure of
-    // get_tilename_by_sitename()
-    // is initialized before we use it below
-    ctx->setup_byname();
-
     log_info("Inserting IO buffers..\n");
 
     get_top_level_pins(ctx, toplevel_ports);
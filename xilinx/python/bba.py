@@ -1,3 +1,5 @@
+import struct, zlib
+
 class BBAWriter:
 	def __init__(self, f):
 		self.f = f
@@ -15,6 +17,8 @@ class BBAWriter:
 		print("str |{}| {}".format(s, comment), file=self.f)
 	def align(self):
 		print("align", file=self.f)
+	def crc32(self, begin, end, comment=""):
+		print("crc32 {} {} {}".format(begin, end, comment), file=self.f)
 	def label(self, s):
 		print("label {}".format(s), file=self.f)
 	def u8(self, n, comment=""):
@@ -25,3 +29,129 @@ class BBAWriter:
 		print("u32 {} {}".format(int(n), comment), file=self.f)
 	def pop(self):
 		print("pop", file=self.f)
+	def close(self):
+		pass
+
+class BinaryBBAWriter:
+	"""
+	Drop-in replacement for BBAWriter that lays out the final chipdb blob
+	directly, with the same semantics as bbasm, rather than writing the
+	textual bba for bbasm to re-tokenise.
+
+	As in bbasm, streams are concatenated without padding and "align" pads
+	to a multiple of 4 in the final blob. Each stream is kept as a list of
+	segments, a new one starting at every align, so that segment positions
+	can be resolved once all sizes are known. Labels are recorded as
+	(stream, segment, offset) and refs as fixups patched in that pass.
+	Strings go in a trailing "strings" stream as in bbasm, except that
+	each distinct string is only stored once. The label "$end" refers to
+	the end of the blob.
+	"""
+	def __init__(self, f, big_endian=False):
+		self.f = f
+		self.endian = ">" if big_endian else "<"
+		# Per stream: list of [starts_aligned, needs_aligned_base, bytearray]
+		self.streams = []
+		self.stream_index = {}
+		self.stack = []
+		self.labels = {}
+		self.fixups = []
+		self.checksums = []
+		self.strings = []
+		self.string_index = {}
+		self.offset32_mode = False
+	def _seg(self):
+		segs = self.streams[self.stack[-1]]
+		return len(segs) - 1, segs[-1]
+	def _pos(self, align):
+		# Position for the next token, which must be aligned to 'align' in the final blob. Within a segment that
+		# is checked directly; a segment that doesn't start at an align must itself start aligned.
+		idx, seg = self._seg()
+		if align > 1:
+			assert len(seg[2]) % align == 0
+			if not seg[0]:
+				seg[1] = True
+		return (self.stack[-1], idx, len(seg[2]))
+	def pre(self, s):
+		pass
+	def post(self, s):
+		pass
+	def push(self, s):
+		if s not in self.stream_index:
+			self.stream_index[s] = len(self.streams)
+			self.streams.append([[False, False, bytearray()]])
+		self.stack.append(self.stream_index[s])
+	def offset32(self):
+		self.offset32_mode = True
+	def ref(self, r, comment=""):
+		self.fixups.append((self._pos(4), r))
+		self._seg()[1][2] += b"\0\0\0\0"
+	def str(self, s, comment=""):
+		if s not in self.string_index:
+			self.string_index[s] = len(self.strings)
+			self.strings.append(s)
+		self.fixups.append((self._pos(4), ("str", s)))
+		self._seg()[1][2] += b"\0\0\0\0"
+	def crc32(self, begin, end, comment=""):
+		self.checksums.append((self._pos(4), begin, end))
+		self._seg()[1][2] += b"\0\0\0\0"
+	def align(self):
+		idx, seg = self._seg()
+		if seg[0] and len(seg[2]) == 0:
+			return
+		self.streams[self.stack[-1]].append([True, False, bytearray()])
+	def label(self, s):
+		self.labels[s] = self._pos(4 if self.offset32_mode else 1)
+	def u8(self, n, comment=""):
+		self._seg()[1][2].append(int(n) & 0xFF)
+	def u16(self, n, comment=""):
+		self._pos(2)
+		self._seg()[1][2] += struct.pack(self.endian + "H", int(n) & 0xFFFF)
+	def u32(self, n, comment=""):
+		self._pos(4)
+		self._seg()[1][2] += struct.pack(self.endian + "I", int(n) & 0xFFFFFFFF)
+	def pop(self):
+		self.stack.pop()
+	def close(self):
+		assert len(self.stack) == 0
+		bases = []
+		cursor = 0
+		for segs in self.streams:
+			stream_bases = []
+			for starts_aligned, needs_aligned_base, buf in segs:
+				if starts_aligned:
+					cursor += -cursor % 4
+				assert cursor % 4 == 0 or not needs_aligned_base
+				stream_bases.append(cursor)
+				cursor += len(buf)
+			bases.append(stream_bases)
+		string_offsets = []
+		for s in self.strings:
+			cursor += -cursor % 4
+			string_offsets.append(cursor)
+			cursor += len(s.encode()) + 1
+		blob = bytearray(cursor)
+		for segs, stream_bases in zip(self.streams, bases):
+			for (_, _, buf), base in zip(segs, stream_bases):
+				blob[base:base + len(buf)] = buf
+		for s, offset in zip(self.strings, string_offsets):
+			data = s.encode()
+			blob[offset:offset + len(data)] = data
+		def resolve(pos):
+			return bases[pos[0]][pos[1]] + pos[2]
+		ref_fmt = self.endian + "i"
+		for pos, target in self.fixups:
+			if isinstance(target, tuple):
+				dest = string_offsets[self.string_index[target[1]]]
+			else:
+				dest = resolve(self.labels[target])
+			src = resolve(pos)
+			struct.pack_into(ref_fmt, blob, src, (dest - src) // 4)
+		def resolve_label(l):
+			return len(blob) if l == "$end" else resolve(self.labels[l])
+		# As in bbasm, all checksums are computed before any is written, so checksum words read as zero
+		values = [zlib.crc32(memoryview(blob)[resolve_label(b):resolve_label(e)]) & 0xFFFFFFFF
+			for _, b, e in self.checksums]
+		for (pos, _, _), value in zip(self.checksums, values):
+			struct.pack_into(self.endian + "I", blob, resolve(pos), value)
+		self.f.write(blob)
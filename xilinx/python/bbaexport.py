@@ -1,10 +1,45 @@
 from xilinx_device import *
-from bba import BBAWriter
+from bba import BBAWriter, BinaryBBAWriter
 import sys, argparse
 import bels, constid
 from nextpnr_structs import *
 import os
 
+def write_node_wires(bba, wires, compress):
+	# The first tile wire is always stored verbatim; with compression the
+	# rest are a stream of zigzag varint (tile delta, wire index delta) pairs
+	for i, (tileidx, wireidx) in enumerate(wires):
+		if i == 0 or not compress:
+			bba.u32(tileidx) # tile index
+			bba.u32(wireidx) # wire index in tile
+		else:
+			for delta in (tileidx - wires[i-1][0], wireidx - wires[i-1][1]):
+				z = (delta << 1) ^ (delta >> 31)
+				while z >= 0x80:
+					bba.u8((z & 0x7F) | 0x80)
+					z >>= 7
+				bba.u8(z)
+	bba.align()
+
+def is_blacklisted_pip(tile_type, src_name, dst_name):
+	# Pips that must never be used by the router; kept in sync with Arch::setup_pip_blacklist,
+	# which still handles chipdbs older than version 4
+	if tile_type.startswith("HCLK_CMT"):
+		return "FREQ_REF" in dst_name
+	elif tile_type.startswith("CLK_HROW_TOP"):
+		return "CK_BUFG_CASCO" in dst_name and "CK_BUFG_CASCIN" in src_name
+	elif tile_type.startswith("HCLK_IOI"):
+		return "RCLK_BEFORE_DIV" in dst_name and "IMUX" in src_name
+	elif "IOI" in tile_type:
+		return ("CLKB" in dst_name and "IMUX22" in src_name) or \
+			("OCLKB" in dst_name and "IOI_OCLK_" in src_name) or \
+			("OCLKM" in dst_name and "IMUX31" in src_name) or \
+			("_CLKDIV" in dst_name and "IMUX8_" in src_name) or \
+			("_SING" in tile_type and dst_name == "IOI_ILOGIC0_CLK" and src_name == "IOI_LEAF_GCLK0")
+	elif tile_type.startswith("CMT_TOP_R"):
+		return "PLLOUT_CLK_FREQ_BB_REBUFOUT" in dst_name or "MMCM_CLK_FREQ_BB" in dst_name
+	return False
+
 def main():
 
 	rwbase = os.path.join(os.path.dirname(os.path.realpath(__file__)), "..")
@@ -14,7 +49,11 @@ def main():
 	parser.add_argument("--metadata", help="nextpnr-xilinx site metadata root", type=str, default=os.path.join(rwbase, "external", "nextpnr-xilinx-meta", "artix7"))
 	parser.add_argument("--device", help="name of device to export", type=str, required=True)
 	parser.add_argument("--constids", help="name of nextpnr constids file to read", type=str, default=os.path.join(rwbase, "constids.inc"))
-	parser.add_argument("--bba", help="bba file to write", type=str, required=True)
+	out = parser.add_mutually_exclusive_group(required=True)
+	out.add_argument("--bba", help="bba file to write", type=str)
+	out.add_argument("--bin", help="binary chipdb to write directly, skipping bba and bbasm", type=str)
+	parser.add_argument("--be", help="write big endian binary chipdb (with --bin)", action="store_true")
+	parser.add_argument("--no-compress-nodes", help="store node tile wire lists uncompressed", action="store_true")
 	args = parser.parse_args()
 	# Read baked-in constids
 	with open(args.constids, "r") as cf:
@@ -63,14 +102,16 @@ def main():
 			tile_insts.append(nti)
 
 	# Begin writing bba
-	with open(args.bba, "w") as bbaf:
-		bba = BBAWriter(bbaf)
+	with (open(args.bba, "w") if args.bba is not None else open(args.bin, "wb")) as bbaf:
+		bba = BBAWriter(bbaf) if args.bba is not None else BinaryBBAWriter(bbaf, args.be)
 		bba.pre('#include "nextpnr.h"')
 		bba.pre('NEXTPNR_NAMESPACE_BEGIN')
 		bba.post('NEXTPNR_NAMESPACE_END')
 		bba.push('chipdb_blob')
 		bba.offset32()
+		bba.label('chipdb_begin')
 		bba.ref('chip_info', 'chip_info')
+		bba.label('sec_constids_begin')
 		bba.label('extra_constid_strs')
 		for i in range(constid.num_base_ids, len(constid.constids)):
 			bba.str(constid.constids[i])
@@ -79,7 +120,9 @@ def main():
 		bba.u32(constid.num_base_ids)
 		bba.u32(len(constid.constids) - constid.num_base_ids)
 		bba.ref('extra_constid_strs')
+		bba.label('sec_constids_end')
 		print("Exporting tile and site type data...")
+		bba.label('sec_tiletypes_begin')
 		for tt in tile_types:
 			# List of wires on bels in tile
 			for bel in tt.bels:
@@ -138,11 +181,14 @@ def main():
 				bba.u32(w.intent) # wire intent constid
 			# Pip data for tiletype
 			bba.label('t{}_pips'.format(tt.index))
+			tt_name = constid.constids[tt.type]
 			for p in tt.pips:
+				blacklisted = is_blacklisted_pip(tt_name, constid.constids[tt.wires[p.from_wire].name],
+					constid.constids[tt.wires[p.to_wire].name])
 				bba.u32(p.from_wire) # src tile wire index
 				bba.u32(p.to_wire) # dst tile wire index
 				bba.u32(p.timing_class) # pip timing class
-				bba.u16(0) # padding
+				bba.u16(1 if blacklisted else 0) # pip attributes (bit 0: blacklisted)
 				bba.u16(p.pip_type.value)
 				bba.u32(p.bel) # bel name constid for site pips
 				bba.u32(p.extra_data) # misc extra data for pseudo-pips (e.g lut permutation info)
@@ -159,7 +205,10 @@ def main():
 			bba.u32(len(tt.pips)) # number of pips
 			bba.ref("t{}_pips".format(tt.index)) # ref to list of pips
 			bba.u32(timing.tile_type_to_tile_index[tt.type] if tt.type in timing.tile_type_to_tile_index else -1) # tile cell timing data index
+		bba.label("sec_tiletypes_end")
 		print("Exporting nodes...")
+		compress_nodes = not args.no_compress_nodes
+		bba.label("sec_nodes_begin")
 		seen_nodes = set()
 		curr = 0
 		total = len(d.tiles)
@@ -195,52 +244,57 @@ def main():
 						# List of tile wires in node
 						bba.label("n{}_tw".format(len(node_wire_count)))
 						# Add interconnect tiles first for better delay estimates in nextpnr
+						node_wires = []
 						for j in range(2):
 							for w in n.wires:
 								if (w.tile.tile_type() in ("INT", "INT_L", "INT_R")) != (j == 0):
 									continue
 								tileidx = w.tile.y * d.width + w.tile.x
-								bba.u32(tileidx) # tile index
-								bba.u32(w.index) # wire index in tile
+								node_wires.append((tileidx, w.index))
 								tile_insts[tileidx].tilewire_to_node[w.index] = len(node_wire_count)
+						write_node_wires(bba, node_wires, compress_nodes)
 						node_intent.append(constid.make(n.wires[0].intent()))
 						node_wire_count.append(len(n.wires))
 			# Connect up row and column ground nodes
 			for i in range(2):
-				wire_count = 0
+				node_wires = []
 				bba.label("n{}_tw".format(len(node_wire_count)))
 				for n in (vcc_nodes if i == 1 else gnd_nodes):
 					for w in n.wires:
 						tileidx = w.tile.y * d.width + w.tile.x
-						bba.u32(tileidx) # tile index
-						bba.u32(w.index) # wire index in tile
+						node_wires.append((tileidx, w.index))
 						tile_insts[tileidx].tilewire_to_node[w.index] = len(node_wire_count)
-						wire_count += 1
 				for col in range(d.width):
 					t = d.tiles_by_xy[col, row]
 					tileidx = row * d.width + col
-					bba.u32(tileidx)
 					wire_idx = tile_types[tile_insts[tileidx].tile_type].row_vcc_wire_index if i == 1 else tile_types[tile_insts[tileidx].tile_type].row_gnd_wire_index
-					bba.u32(wire_idx)
+					node_wires.append((tileidx, wire_idx))
 					tile_insts[tileidx].tilewire_to_node[wire_idx] = len(node_wire_count)
-					wire_count += 1
-				node_wire_count.append(wire_count)
+				write_node_wires(bba, node_wires, compress_nodes)
+				node_wire_count.append(len(node_wires))
 				node_intent.append(constid.make("PSEUDO_VCC" if i == 1 else "PSEUDO_GND"))
 		# Create the global Vcc and Ground nodes
 		for i in range(2):
-			wire_count = 0
+			node_wires = []
 			bba.label("n{}_tw".format(len(node_wire_count)))
 			for row in range(d.height):
 				t = d.tiles_by_xy[0, row]
 				tileidx = row * d.width
-				bba.u32(tileidx)
 				wire_idx = tile_types[tile_insts[tileidx].tile_type].global_vcc_wire_index if i == 1 else tile_types[tile_insts[tileidx].tile_type].global_gnd_wire_index
-				bba.u32(wire_idx)
+				node_wires.append((tileidx, wire_idx))
 				tile_insts[tileidx].tilewire_to_node[wire_idx] = len(node_wire_count)
-				wire_count += 1
-			node_wire_count.append(wire_count)
+			write_node_wires(bba, node_wires, compress_nodes)
+			node_wire_count.append(len(node_wires))
 			node_intent.append(constid.make("PSEUDO_VCC" if i == 1 else "PSEUDO_GND"))
+		# List of nodes
+		bba.label("nodes")
+		for i in range(len(node_wire_count)):
+			bba.u32(node_wire_count[i]) # number of tile wires in node
+			bba.u32(node_intent[i]) # intent code constid of node
+			bba.ref("n{}_tw".format(i)) # reference to list of tile wires in node, created earlier
+		bba.label("sec_nodes_end")
 		print("Exporting tile and site instances...")
+		bba.label("sec_tileinsts_begin")
 		for ti in tile_insts:
 			# Mapping from tile wire to node index
 			bba.label("ti{}_wire_to_node".format(ti.index))
@@ -266,13 +320,9 @@ def main():
 			bba.ref("ti{}_wire_to_node".format(ti.index)) # reference to tilewire-to-node list
 			bba.u32(len(ti.sites)) # number of sites in tile
 			bba.ref("ti{}_sites".format(ti.index)) # reference to list of site data
-		# List of nodes
-		bba.label("nodes")
-		for i in range(len(node_wire_count)):
-			bba.u32(node_wire_count[i]) # number of tile wires in node
-			bba.u32(node_intent[i]) # intent code constid of node
-			bba.ref("n{}_tw".format(i)) # reference to list of tile wires in node, created earlier
+		bba.label("sec_tileinsts_end")
 		# Wire timing classes
+		bba.label("sec_timing_begin")
 		bba.label("wire_timing_classes")
 		for wc, i in sorted(timing.wire_classes.items(), key=lambda e: e[1]):
 			bba.u32(wc.r) # resistance
@@ -332,11 +382,18 @@ def main():
 		bba.ref("tile_cell_timing") # ref to list of cell timing tile types
 		bba.ref("wire_timing_classes") # ref to wire class data list
 		bba.ref("pip_timing_classes") # ref to pip class data list
+		bba.label("sec_timing_end")
+		# Section directory, allowing nextpnr to prefetch only what it needs
+		bba.label("sections")
+		for i, sec in enumerate(("constids", "tiletypes", "tileinsts", "nodes", "timing")):
+			bba.u32(i) # section ID
+			bba.ref("sec_{}_begin".format(sec)) # ref to start of section
+			bba.ref("sec_{}_end".format(sec)) # ref to end of section
 		# Main chip info structure
 		bba.label("chip_info")
 		bba.str(d.name) # device name char*
 		bba.str("prjxray") # generator name char*
-		bba.u32(1) # version
+		bba.u32(5) # version
 		bba.u32(d.width) # tile grid width
 		bba.u32(d.height) # tile grid height
 		bba.u32(len(tile_insts)) # number of tiles
@@ -348,6 +405,11 @@ def main():
 		bba.ref("extra_constids") # reference to list of constid strings (extra to baked-in ones)
 		bba.u32(1) # only one speed grade currently
 		bba.ref("timing") # timing data
+		bba.crc32("chipdb_begin", "$end") # checksum of the whole blob, with this word as zero
+		bba.u32(5) # number of sections
+		bba.ref("sections") # ref to section directory
+		bba.u32(1 if compress_nodes else 0) # node tile wire list encoding
 		bba.pop()
+		bba.close()
 if __name__ == '__main__':
 	main()